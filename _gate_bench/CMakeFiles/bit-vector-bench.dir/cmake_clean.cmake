@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bit-vector-bench.dir/bench/bit-vector-bench.cpp.o"
+  "CMakeFiles/bit-vector-bench.dir/bench/bit-vector-bench.cpp.o.d"
+  "bit-vector-bench"
+  "bit-vector-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bit-vector-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
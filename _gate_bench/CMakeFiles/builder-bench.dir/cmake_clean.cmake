@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/builder-bench.dir/bench/builder-bench.cpp.o"
+  "CMakeFiles/builder-bench.dir/bench/builder-bench.cpp.o.d"
+  "builder-bench"
+  "builder-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/builder-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
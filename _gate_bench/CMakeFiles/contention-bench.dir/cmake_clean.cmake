@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/contention-bench.dir/bench/contention-bench.cpp.o"
+  "CMakeFiles/contention-bench.dir/bench/contention-bench.cpp.o.d"
+  "contention-bench"
+  "contention-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/contention-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/deque-bench.dir/bench/deque-bench.cpp.o"
+  "CMakeFiles/deque-bench.dir/bench/deque-bench.cpp.o.d"
+  "deque-bench"
+  "deque-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/deque-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/hot-path-bench.dir/bench/hot-path-bench.cpp.o"
+  "CMakeFiles/hot-path-bench.dir/bench/hot-path-bench.cpp.o.d"
+  "hot-path-bench"
+  "hot-path-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/hot-path-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/page-cow-bench.dir/bench/page-cow-bench.cpp.o"
+  "CMakeFiles/page-cow-bench.dir/bench/page-cow-bench.cpp.o.d"
+  "page-cow-bench"
+  "page-cow-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/page-cow-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/realloc-bench.dir/bench/realloc-bench.cpp.o"
+  "CMakeFiles/realloc-bench.dir/bench/realloc-bench.cpp.o.d"
+  "realloc-bench"
+  "realloc-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/realloc-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/shared-count-bench.dir/bench/shared-count-bench.cpp.o"
+  "CMakeFiles/shared-count-bench.dir/bench/shared-count-bench.cpp.o.d"
+  "shared-count-bench"
+  "shared-count-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/shared-count-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/soa-bench.dir/bench/soa-bench.cpp.o"
+  "CMakeFiles/soa-bench.dir/bench/soa-bench.cpp.o.d"
+  "soa-bench"
+  "soa-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/soa-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
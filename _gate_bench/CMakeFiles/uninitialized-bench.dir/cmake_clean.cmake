@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/uninitialized-bench.dir/bench/uninitialized-bench.cpp.o"
+  "CMakeFiles/uninitialized-bench.dir/bench/uninitialized-bench.cpp.o.d"
+  "uninitialized-bench"
+  "uninitialized-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/uninitialized-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/alignment-bench.dir/bench/alignment-bench.cpp.o"
+  "CMakeFiles/alignment-bench.dir/bench/alignment-bench.cpp.o.d"
+  "alignment-bench"
+  "alignment-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/alignment-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
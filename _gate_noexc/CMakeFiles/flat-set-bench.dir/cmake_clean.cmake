@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/flat-set-bench.dir/bench/flat-set-bench.cpp.o"
+  "CMakeFiles/flat-set-bench.dir/bench/flat-set-bench.cpp.o.d"
+  "flat-set-bench"
+  "flat-set-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/flat-set-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/move-only-bench.dir/bench/move-only-bench.cpp.o"
+  "CMakeFiles/move-only-bench.dir/bench/move-only-bench.cpp.o.d"
+  "move-only-bench"
+  "move-only-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/move-only-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/relocation-bench.dir/bench/relocation-bench.cpp.o"
+  "CMakeFiles/relocation-bench.dir/bench/relocation-bench.cpp.o.d"
+  "relocation-bench"
+  "relocation-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/relocation-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/small-mode-bench.dir/bench/small-mode-bench.cpp.o"
+  "CMakeFiles/small-mode-bench.dir/bench/small-mode-bench.cpp.o.d"
+  "small-mode-bench"
+  "small-mode-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/small-mode-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
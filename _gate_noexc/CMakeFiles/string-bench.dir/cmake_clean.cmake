@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/string-bench.dir/bench/string-bench.cpp.o"
+  "CMakeFiles/string-bench.dir/bench/string-bench.cpp.o.d"
+  "string-bench"
+  "string-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/string-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,37 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/test/allocation-counter.cpp" "CMakeFiles/tests.dir/test/allocation-counter.cpp.o" "gcc" "CMakeFiles/tests.dir/test/allocation-counter.cpp.o.d"
+  "/root/repo/test/bit-vector-test.cpp" "CMakeFiles/tests.dir/test/bit-vector-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/bit-vector-test.cpp.o.d"
+  "/root/repo/test/complexity-test.cpp" "CMakeFiles/tests.dir/test/complexity-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/complexity-test.cpp.o.d"
+  "/root/repo/test/constexpr-test.cpp" "CMakeFiles/tests.dir/test/constexpr-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/constexpr-test.cpp.o.d"
+  "/root/repo/test/deque-test.cpp" "CMakeFiles/tests.dir/test/deque-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/deque-test.cpp.o.d"
+  "/root/repo/test/element.cpp" "CMakeFiles/tests.dir/test/element.cpp.o" "gcc" "CMakeFiles/tests.dir/test/element.cpp.o.d"
+  "/root/repo/test/flat-set-test.cpp" "CMakeFiles/tests.dir/test/flat-set-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/flat-set-test.cpp.o.d"
+  "/root/repo/test/heap-storage-test.cpp" "CMakeFiles/tests.dir/test/heap-storage-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/heap-storage-test.cpp.o.d"
+  "/root/repo/test/interner-test.cpp" "CMakeFiles/tests.dir/test/interner-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/interner-test.cpp.o.d"
+  "/root/repo/test/io-test.cpp" "CMakeFiles/tests.dir/test/io-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/io-test.cpp.o.d"
+  "/root/repo/test/memfd-storage-test.cpp" "CMakeFiles/tests.dir/test/memfd-storage-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/memfd-storage-test.cpp.o.d"
+  "/root/repo/test/profiler-test.cpp" "CMakeFiles/tests.dir/test/profiler-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/profiler-test.cpp.o.d"
+  "/root/repo/test/rope-test.cpp" "CMakeFiles/tests.dir/test/rope-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/rope-test.cpp.o.d"
+  "/root/repo/test/shared-count-test.cpp" "CMakeFiles/tests.dir/test/shared-count-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/shared-count-test.cpp.o.d"
+  "/root/repo/test/soa-vector-test.cpp" "CMakeFiles/tests.dir/test/soa-vector-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/soa-vector-test.cpp.o.d"
+  "/root/repo/test/string-test.cpp" "CMakeFiles/tests.dir/test/string-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/string-test.cpp.o.d"
+  "/root/repo/test/traits-test.cpp" "CMakeFiles/tests.dir/test/traits-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/traits-test.cpp.o.d"
+  "/root/repo/test/vector-builder-test.cpp" "CMakeFiles/tests.dir/test/vector-builder-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/vector-builder-test.cpp.o.d"
+  "/root/repo/test/vector-test.cpp" "CMakeFiles/tests.dir/test/vector-test.cpp.o" "gcc" "CMakeFiles/tests.dir/test/vector-test.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
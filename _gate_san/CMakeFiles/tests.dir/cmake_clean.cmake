@@ -0,0 +1,47 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/tests.dir/test/allocation-counter.cpp.o"
+  "CMakeFiles/tests.dir/test/allocation-counter.cpp.o.d"
+  "CMakeFiles/tests.dir/test/bit-vector-test.cpp.o"
+  "CMakeFiles/tests.dir/test/bit-vector-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/complexity-test.cpp.o"
+  "CMakeFiles/tests.dir/test/complexity-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/constexpr-test.cpp.o"
+  "CMakeFiles/tests.dir/test/constexpr-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/deque-test.cpp.o"
+  "CMakeFiles/tests.dir/test/deque-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/element.cpp.o"
+  "CMakeFiles/tests.dir/test/element.cpp.o.d"
+  "CMakeFiles/tests.dir/test/flat-set-test.cpp.o"
+  "CMakeFiles/tests.dir/test/flat-set-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/heap-storage-test.cpp.o"
+  "CMakeFiles/tests.dir/test/heap-storage-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/interner-test.cpp.o"
+  "CMakeFiles/tests.dir/test/interner-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/io-test.cpp.o"
+  "CMakeFiles/tests.dir/test/io-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/memfd-storage-test.cpp.o"
+  "CMakeFiles/tests.dir/test/memfd-storage-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/profiler-test.cpp.o"
+  "CMakeFiles/tests.dir/test/profiler-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/rope-test.cpp.o"
+  "CMakeFiles/tests.dir/test/rope-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/shared-count-test.cpp.o"
+  "CMakeFiles/tests.dir/test/shared-count-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/soa-vector-test.cpp.o"
+  "CMakeFiles/tests.dir/test/soa-vector-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/string-test.cpp.o"
+  "CMakeFiles/tests.dir/test/string-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/traits-test.cpp.o"
+  "CMakeFiles/tests.dir/test/traits-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/vector-builder-test.cpp.o"
+  "CMakeFiles/tests.dir/test/vector-builder-test.cpp.o.d"
+  "CMakeFiles/tests.dir/test/vector-test.cpp.o"
+  "CMakeFiles/tests.dir/test/vector-test.cpp.o.d"
+  "tests"
+  "tests.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/tests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,40 @@
+#include "bench-utils.h"
+#include "heap-storage.h"
+#include "socow-vector.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace {
+
+template <typename Storage>
+void run(std::string_view name, std::size_t bytes) {
+  socow_vector<float, 4, Storage> v;
+  v.resize_for_overwrite(bytes / sizeof(float));
+  for (std::size_t i = 0; i < v.size(); ++i) {
+    v[i] = static_cast<float>(i % 7);
+  }
+  const auto& cv = v;
+
+  std::string prefix = std::string(name) + " " + std::to_string(bytes >> 10) + " KiB (address % 64 = " +
+                       std::to_string(reinterpret_cast<std::uintptr_t>(cv.data()) % 64) + ")";
+  std::size_t iterations = (std::size_t(1) << 30) / bytes + 1;
+  report(prefix + " sum", measure_ns(iterations, [&] {
+           float sum = 0;
+           for (float x : cv) {
+             sum += x;
+           }
+           do_not_optimize(sum);
+         }));
+}
+
+} // namespace
+
+int main() {
+  for (std::size_t bytes : {std::size_t(64) << 10, std::size_t(4) << 20, std::size_t(256) << 20}) {
+    run<heap_storage>("heap_storage", bytes);
+    run<basic_heap_storage<64>>("basic_heap_storage<64>", bytes);
+    run<basic_heap_storage<64, (std::size_t(2) << 20)>>("basic_heap_storage<64, 2 MiB>", bytes);
+  }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+
+template <typename T>
+void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+// Runs `body` `iterations` times per round and returns the best observed time per iteration (ns)
+template <typename F>
+double measure_ns(std::size_t iterations, F&& body, std::size_t rounds = 5) {
+  double best = 0;
+  for (std::size_t round = 0; round != rounds; ++round) {
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != iterations; ++i) {
+      body();
+    }
+    auto finish = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(finish - start).count() / iterations;
+    best = round == 0 ? ns : std::min(best, ns);
+  }
+  return best;
+}
+
+inline void report(std::string_view name, double ns) {
+  std::cout << std::left << std::setw(48) << name << std::right << std::setw(12) << std::fixed
+            << std::setprecision(1) << ns << " ns/op\n";
+}
@@ -0,0 +1,70 @@
+#include "bench-utils.h"
+#include "socow-vector.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t N = 1 << 20;
+
+} // namespace
+
+// Counts and intersects masks of a million flags: the packed vector processes 64 of them per word,
+// and a mask of a few hundred flags is copied without touching the heap
+int main() {
+  constexpr std::size_t iterations = 20;
+
+  socow_vector<bool> packed_a;
+  socow_vector<bool> packed_b;
+  std::vector<char> bytes_a;
+  std::vector<char> bytes_b;
+  std::vector<bool> std_a;
+  for (std::size_t i = 0; i != N; ++i) {
+    packed_a.push_back(i % 3 == 0);
+    packed_b.push_back(i % 5 == 0);
+    bytes_a.push_back(i % 3 == 0);
+    bytes_b.push_back(i % 5 == 0);
+    std_a.push_back(i % 3 == 0);
+  }
+
+  report("socow_vector<bool> count per 64 flags", measure_ns(iterations, [&] {
+           do_not_optimize(packed_a.count());
+         }) / (N / 64));
+  report("std::vector<char> count per 64 flags", measure_ns(iterations, [&] {
+           std::size_t count = 0;
+           for (char flag : bytes_a) {
+             count += flag != 0;
+           }
+           do_not_optimize(count);
+         }) / (N / 64));
+  report("std::vector<bool> count per 64 flags", measure_ns(iterations, [&] {
+           std::size_t count = 0;
+           for (bool flag : std_a) {
+             count += flag;
+           }
+           do_not_optimize(count);
+         }) / (N / 64));
+
+  report("socow_vector<bool> &= per 64 flags", measure_ns(iterations, [&] {
+           packed_a &= packed_b;
+           do_not_optimize(packed_a);
+         }) / (N / 64));
+  report("std::vector<char> &= per 64 flags", measure_ns(iterations, [&] {
+           for (std::size_t i = 0; i != N; ++i) {
+             bytes_a[i] &= bytes_b[i];
+           }
+           do_not_optimize(bytes_a);
+         }) / (N / 64));
+
+  socow_vector<bool> mask(socow_vector_small_size<bool>(), true);
+  std::vector<bool> std_mask(socow_vector_small_size<bool>(), true);
+  report("socow_vector<bool> copy of an inline mask", measure_ns(N, [&] {
+           socow_vector<bool> copy = mask;
+           do_not_optimize(copy);
+         }));
+  report("std::vector<bool> copy of the same mask", measure_ns(N, [&] {
+           std::vector<bool> copy = std_mask;
+           do_not_optimize(copy);
+         }));
+}
@@ -0,0 +1,79 @@
+#include "bench-utils.h"
+#include "socow-vector-builder.h"
+#include "socow-vector.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t N = 1 << 23;
+
+template <typename Produce>
+void run_producers(std::size_t threads, Produce produce) {
+  std::vector<std::thread> producers;
+  for (std::size_t t = 0; t != threads; ++t) {
+    producers.emplace_back(produce, t);
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+}
+
+} // namespace
+
+// Eight million values produced by several threads: a shared vector behind a lock,
+// per-thread std::vectors concatenated on one thread, and the builder
+int main() {
+  constexpr std::size_t iterations = 3;
+  std::size_t max_threads = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+
+  for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+    std::size_t per_thread = N / threads;
+    std::string suffix = ", " + std::to_string(threads) + " threads";
+
+    report("locked push_back" + suffix, measure_ns(iterations, [&] {
+             socow_vector<std::uint64_t> result;
+             std::mutex lock;
+             run_producers(threads, [&](std::size_t t) {
+               for (std::size_t i = 0; i != per_thread; ++i) {
+                 std::lock_guard guard(lock);
+                 result.push_back(t * per_thread + i);
+               }
+             });
+             do_not_optimize(result);
+           }) / N);
+
+    report("std::vector per thread + concatenation" + suffix, measure_ns(iterations, [&] {
+             std::vector<std::vector<std::uint64_t>> parts(threads);
+             run_producers(threads, [&](std::size_t t) {
+               for (std::size_t i = 0; i != per_thread; ++i) {
+                 parts[t].push_back(t * per_thread + i);
+               }
+             });
+             socow_vector<std::uint64_t> result;
+             for (const std::vector<std::uint64_t>& part : parts) {
+               for (std::uint64_t value : part) {
+                 result.push_back(value);
+               }
+             }
+             do_not_optimize(result);
+           }) / N);
+
+    report("builder" + suffix, measure_ns(iterations, [&] {
+             socow_vector<std::uint64_t>::builder builder(threads);
+             run_producers(threads, [&](std::size_t t) {
+               for (std::size_t i = 0; i != per_thread; ++i) {
+                 builder[t].push_back(t * per_thread + i);
+               }
+             });
+             socow_vector<std::uint64_t> result = builder.finish(threads);
+             do_not_optimize(result);
+           }) / N);
+  }
+}
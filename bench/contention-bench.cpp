@@ -0,0 +1,268 @@
+#include "bench-utils.h"
+#include "shared-count.h"
+#include "shared-data.h"
+#include "socow-vector.h"
+#include "vector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+// How long every scenario runs
+constexpr auto DURATION = std::chrono::milliseconds(200);
+
+// Short operations are timed in batches, so that reading the clock doesn't dominate the samples
+constexpr std::size_t BATCH = 32;
+
+constexpr std::size_t ELEMENTS = 4096;
+
+constexpr std::size_t QUEUE_DEPTH = 64;
+
+// Operations done by one thread and their latencies (ns per operation)
+struct thread_stats {
+  std::size_t ops = 0;
+  std::vector<double> samples;
+};
+
+double elapsed_ns(bench_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+}
+
+// Runs `body(index, stats, stop)` on `threads` threads for DURATION; returns the elapsed seconds
+template <typename Body>
+double run_threads(std::size_t threads, std::vector<thread_stats>& stats, Body body) {
+  stats.assign(threads, {});
+  std::atomic<bool> stop = false;
+  std::atomic<std::size_t> ready = 0;
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; t != threads; ++t) {
+    workers.emplace_back([&, t] {
+      ready.fetch_add(1);
+      while (ready.load() != threads) {
+        std::this_thread::yield();
+      }
+      body(t, stats[t], stop);
+    });
+  }
+  while (ready.load() != threads) {
+    std::this_thread::yield();
+  }
+  auto start = bench_clock::now();
+  std::this_thread::sleep_for(DURATION);
+  stop.store(true);
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+// Prints the throughput of the selected threads with the median and the 99th percentile of their latencies
+void report_latency(std::string_view name, const std::vector<thread_stats>& stats, double seconds,
+                    std::size_t first = 0, std::size_t last = static_cast<std::size_t>(-1)) {
+  std::size_t ops = 0;
+  std::vector<double> samples;
+  for (std::size_t t = first; t < std::min(last, stats.size()); ++t) {
+    ops += stats[t].ops;
+    samples.insert(samples.end(), stats[t].samples.begin(), stats[t].samples.end());
+  }
+  auto percentile = [&](double p) {
+    if (samples.empty()) {
+      return 0.0;
+    }
+    auto it = samples.begin() + static_cast<std::ptrdiff_t>(p * static_cast<double>(samples.size() - 1));
+    std::nth_element(samples.begin(), it, samples.end());
+    return *it;
+  };
+  std::cout << std::left << std::setw(48) << name << std::right << std::fixed << std::setprecision(2) << std::setw(10)
+            << static_cast<double>(ops) / seconds / 1e6 << " Mops/s" << std::setprecision(1) << std::setw(10)
+            << percentile(0.5) << " ns p50" << std::setw(10) << percentile(0.99) << " ns p99\n";
+}
+
+socow_vector<int> make_vector() {
+  socow_vector<int> result;
+  for (std::size_t i = 0; i != ELEMENTS; ++i) {
+    result.push_back(static_cast<int>(i));
+  }
+  return result;
+}
+
+template <typename Count>
+shared_data<vector<int>, Count> make_buffer() {
+  vector<int> elements;
+  for (std::size_t i = 0; i != ELEMENTS; ++i) {
+    elements.push_back(static_cast<int>(i));
+  }
+  return shared_data<vector<int>, Count>(std::move(elements));
+}
+
+// Every thread copies and drops the same buffer, which it doesn't own: all of them write one reference count
+template <typename Copyable>
+void copy_and_drop(std::string_view name, const Copyable& origin, std::size_t threads) {
+  std::vector<thread_stats> stats;
+  double seconds = run_threads(threads, stats, [&](std::size_t, thread_stats& s, const std::atomic<bool>& stop) {
+    while (!stop.load(std::memory_order_relaxed)) {
+      auto start = bench_clock::now();
+      for (std::size_t i = 0; i != BATCH; ++i) {
+        Copyable copy = origin;
+        do_not_optimize(copy);
+      }
+      s.samples.push_back(elapsed_ns(start) / BATCH);
+      s.ops += BATCH;
+    }
+  });
+  report_latency(std::string(name) + ", " + std::to_string(threads) + " threads", stats, seconds);
+}
+
+// Readers take a snapshot and iterate over it, while a writer takes one and writes to it, unsharing the buffer
+void readers_and_writer(std::size_t threads) {
+  const socow_vector<int> origin = make_vector();
+  std::vector<thread_stats> stats;
+  double seconds = run_threads(threads, stats, [&](std::size_t t, thread_stats& s, const std::atomic<bool>& stop) {
+    int round = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+      auto start = bench_clock::now();
+      socow_vector<int> snapshot = origin;
+      if (t == 0) {
+        snapshot[0] = ++round;
+      } else {
+        long sum = 0;
+        for (int value : std::as_const(snapshot)) {
+          sum += value;
+        }
+        do_not_optimize(sum);
+      }
+      s.samples.push_back(elapsed_ns(start));
+      ++s.ops;
+    }
+  });
+  std::string suffix = ", " + std::to_string(threads - 1) + " readers";
+  report_latency("writer: snapshot + unpin" + suffix, stats, seconds, 0, 1);
+  report_latency("reader: snapshot + iterate" + suffix, stats, seconds, 1);
+}
+
+// One producer publishes snapshots that differ from the previous one in an element, consumers read and drop them.
+// The last reference to a snapshot is usually released on a consumer, not on the producer that owns the count.
+void producer_consumers(std::size_t threads) {
+  struct message {
+    socow_vector<int> snapshot;
+    bench_clock::time_point sent;
+  };
+  std::mutex lock;
+  std::condition_variable changed;
+  std::deque<message> queue;
+
+  std::vector<thread_stats> stats;
+  double seconds = run_threads(threads, stats, [&](std::size_t t, thread_stats& s, const std::atomic<bool>& stop) {
+    if (t == 0) {
+      socow_vector<int> current = make_vector();
+      for (int round = 0; !stop.load(std::memory_order_relaxed); ++round) {
+        auto start = bench_clock::now();
+        socow_vector<int> next = current;
+        next[static_cast<std::size_t>(round) % ELEMENTS] = round;
+        current = next;
+        s.samples.push_back(elapsed_ns(start));
+        std::unique_lock guard(lock);
+        changed.wait(guard, [&] { return queue.size() < QUEUE_DEPTH || stop.load(std::memory_order_relaxed); });
+        queue.push_back({std::move(next), bench_clock::now()});
+        ++s.ops;
+        changed.notify_all();
+      }
+      std::lock_guard guard(lock);
+      changed.notify_all();
+      return;
+    }
+    while (true) {
+      std::unique_lock guard(lock);
+      changed.wait(guard, [&] { return !queue.empty() || stop.load(std::memory_order_relaxed); });
+      if (queue.empty()) {
+        return;
+      }
+      message m = std::move(queue.front());
+      queue.pop_front();
+      changed.notify_all();
+      guard.unlock();
+      s.samples.push_back(elapsed_ns(m.sent));
+      ++s.ops;
+      do_not_optimize(std::as_const(m.snapshot)[0]);
+    }
+  });
+  std::string suffix = ", " + std::to_string(threads - 1) + " consumers";
+  report_latency("producer: snapshot + unpin" + suffix, stats, seconds, 0, 1);
+  report_latency("consumer: handoff latency" + suffix, stats, seconds, 1);
+}
+
+// A reader keeps reading the size and the first elements of its copy, which go through the vector header
+// in the control block, while the other threads copy and drop either the same buffer or an unrelated one.
+// The difference is the cost of the reference count sharing a cache line with the header.
+void false_sharing(std::size_t threads) {
+  const socow_vector<int> hot = make_vector();
+  const socow_vector<int> cold = make_vector();
+  std::size_t block = shared_data<vector<int>>::control_block_size();
+  std::cout << "control block: " << block << " bytes, reference count at +0, vector header at +"
+            << block - sizeof(vector<int>) << " (one cache line of " << SOCOW_CACHE_LINE_SIZE << ")\n";
+
+  for (const socow_vector<int>* contended : {&cold, &hot}) {
+    std::vector<thread_stats> stats;
+    double seconds = run_threads(threads, stats, [&](std::size_t t, thread_stats& s, const std::atomic<bool>& stop) {
+      if (t == 0) {
+        const socow_vector<int> mine = hot;
+        while (!stop.load(std::memory_order_relaxed)) {
+          auto start = bench_clock::now();
+          std::size_t sum = 0;
+          for (std::size_t i = 0; i != BATCH; ++i) {
+            sum += mine.size() + static_cast<std::size_t>(mine[i]);
+          }
+          do_not_optimize(sum);
+          s.samples.push_back(elapsed_ns(start) / BATCH);
+          s.ops += BATCH;
+        }
+        return;
+      }
+      while (!stop.load(std::memory_order_relaxed)) {
+        socow_vector<int> copy = *contended;
+        do_not_optimize(copy);
+        ++s.ops;
+      }
+    });
+    std::string others = contended == &hot ? "same buffer" : "other buffer";
+    report_latency("header reads, " + std::to_string(threads - 1) + " copying " + others, stats, seconds, 0, 1);
+  }
+}
+
+} // namespace
+
+// Shared buffers under contention: throughput of all the threads of a role, latency percentiles of their operations.
+// The single-thread numbers of the counts themselves are in shared-count-bench.
+int main() {
+  std::size_t max_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 2);
+
+  const shared_data<vector<int>, atomic_count> atomic_origin = make_buffer<atomic_count>();
+  const shared_data<vector<int>, biased_count> biased_origin = make_buffer<biased_count>();
+  const socow_vector<int> vector_origin = make_vector();
+  for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+    copy_and_drop("atomic_count copy + drop", atomic_origin, threads);
+    copy_and_drop("biased_count copy + drop", biased_origin, threads);
+    copy_and_drop("socow_vector copy + drop", vector_origin, threads);
+  }
+
+  for (std::size_t threads = 2; threads <= max_threads; threads *= 2) {
+    readers_and_writer(threads);
+    producer_consumers(threads);
+    false_sharing(threads);
+  }
+}
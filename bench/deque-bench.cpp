@@ -0,0 +1,35 @@
+#include "bench-utils.h"
+#include "socow-deque.h"
+#include "socow-vector.h"
+
+#include <cstddef>
+#include <string>
+
+namespace {
+
+// Work queue that stays about `depth` items deep: every step takes one item from the front and adds one at the back
+template <typename Queue, typename PopFront>
+double queue_step_ns(std::size_t depth, PopFront pop_front) {
+  Queue queue;
+  for (std::size_t i = 0; i != depth; ++i) {
+    queue.push_back(static_cast<int>(i));
+  }
+  return measure_ns(100'000, [&] {
+    int item = queue.front();
+    pop_front(queue);
+    queue.push_back(item + 1);
+    do_not_optimize(queue);
+  });
+}
+
+} // namespace
+
+int main() {
+  for (std::size_t depth : {8, 64, 1024}) {
+    std::string suffix = ", depth " + std::to_string(depth);
+    report("socow_vector erase(begin()) + push_back" + suffix,
+           queue_step_ns<socow_vector<int>>(depth, [](auto& queue) { queue.erase(queue.begin()); }));
+    report("socow_deque pop_front + push_back" + suffix,
+           queue_step_ns<socow_deque<int>>(depth, [](auto& queue) { queue.pop_front(); }));
+  }
+}
@@ -0,0 +1,90 @@
+#include "bench-utils.h"
+#include "socow-flat-set.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Cheap reproducible keys that defeat the branch predictor
+struct xorshift {
+  std::uint64_t state = 88172645463325252ull;
+
+  std::uint64_t operator()() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+};
+
+template <typename Set>
+Set build(std::size_t n) {
+  Set s;
+  for (std::size_t i = 0; i != n; ++i) {
+    s.insert(static_cast<int>(2 * i));
+  }
+  return s;
+}
+
+// Attribute sets of a few keys that are copied much more often than changed
+void copy_small(std::size_t n) {
+  constexpr std::size_t iterations = 1'000'000;
+  std::string suffix = " n=" + std::to_string(n) + " copy";
+
+  auto flat = build<socow_flat_set<int, 4>>(n);
+  auto tree = build<std::set<int>>(n);
+  report("socow_flat_set" + suffix, measure_ns(iterations, [&] {
+           auto copy = flat;
+           do_not_optimize(copy);
+         }));
+  report("std::set" + suffix, measure_ns(iterations, [&] {
+           auto copy = tree;
+           do_not_optimize(copy);
+         }));
+}
+
+// Lookups of random keys in a set much larger than the cache
+void lookup_large(std::size_t n) {
+  constexpr std::size_t iterations = 1'000'000;
+  std::string suffix = " n=" + std::to_string(n) + " lower_bound";
+
+  std::vector<int> sorted;
+  for (std::size_t i = 0; i != n; ++i) {
+    sorted.push_back(static_cast<int>(2 * i));
+  }
+  socow_flat_set<int, 4> flat;
+  flat.insert_range(sorted);
+  socow_eytzinger_set<int> eytzinger(flat);
+  int range = static_cast<int>(2 * n - 1);
+
+  xorshift next;
+  report("std::lower_bound" + suffix, measure_ns(iterations, [&] {
+           int key = static_cast<int>(next() % range);
+           do_not_optimize(*std::lower_bound(sorted.begin(), sorted.end(), key));
+         }));
+  report("socow_flat_set" + suffix, measure_ns(iterations, [&] {
+           int key = static_cast<int>(next() % range);
+           do_not_optimize(*flat.lower_bound(key));
+         }));
+  report("socow_eytzinger_set" + suffix, measure_ns(iterations, [&] {
+           int key = static_cast<int>(next() % range);
+           do_not_optimize(*eytzinger.lower_bound(key));
+         }));
+}
+
+} // namespace
+
+int main() {
+  for (std::size_t n : {1, 4, 16}) {
+    copy_small(n);
+  }
+  for (std::size_t n : {1'000, 1'000'000, 16'000'000}) {
+    lookup_large(n);
+  }
+}
@@ -0,0 +1,65 @@
+#include "bench-utils.h"
+#include "socow-vector.h"
+
+#include <cstddef>
+#include <string>
+
+// Explicit instantiations give every method an out-of-line copy, so the code size of each one is reported by
+//   ci-extra/code-size.sh cmake-build-Benchmark/hot-path-bench 'socow_vector<int, 8ul'
+// The `hot_path::` entry points show what a call site inlines.
+template class socow_vector<int, 8>;
+template class socow_vector<std::string, 8>;
+
+using int_vector = socow_vector<int, 8>;
+
+namespace hot_path {
+
+[[gnu::noinline]] void push_back(int_vector& v, int value) {
+  v.push_back(value);
+}
+
+[[gnu::noinline]] int& subscript(int_vector& v, std::size_t index) {
+  return v[index];
+}
+
+[[gnu::noinline]] int* begin(int_vector& v) {
+  return v.begin();
+}
+
+} // namespace hot_path
+
+int main() {
+  constexpr std::size_t n = 1 << 16;
+
+  report("push_back into unique heap buffer", measure_ns(100, [] {
+           int_vector v;
+           v.reserve(n);
+           for (std::size_t i = 0; i != n; ++i) {
+             hot_path::push_back(v, static_cast<int>(i));
+           }
+           do_not_optimize(v);
+         }) / n);
+
+  int_vector v;
+  for (std::size_t i = 0; i != n; ++i) {
+    v.push_back(static_cast<int>(i));
+  }
+  report("operator[] on unique heap buffer", measure_ns(100, [&] {
+           for (std::size_t i = 0; i != n; ++i) {
+             ++hot_path::subscript(v, i);
+           }
+         }) / n);
+
+  report("push_back with spill", measure_ns(100'000, [] {
+           int_vector small;
+           for (int i = 0; i != 9; ++i) {
+             hot_path::push_back(small, i);
+           }
+           do_not_optimize(small);
+         }));
+
+  report("begin() with unshare", measure_ns(10'000, [&] {
+           int_vector copy = v;
+           do_not_optimize(hot_path::begin(copy));
+         }));
+}
@@ -0,0 +1,73 @@
+#include "bench-utils.h"
+#include "socow-vector.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace {
+
+struct payload {
+  std::size_t value;
+};
+
+constexpr std::size_t SMALL_SIZE = 4;
+
+using boxed = std::shared_ptr<std::unique_ptr<payload>>;
+
+const payload& unbox(const std::unique_ptr<payload>& p) {
+  return *p;
+}
+
+const payload& unbox(const boxed& p) {
+  return **p;
+}
+
+template <typename Vector, typename Make>
+Vector build(std::size_t n, Make make) {
+  Vector v;
+  for (std::size_t i = 0; i != n; ++i) {
+    v.push_back(make(i));
+  }
+  return v;
+}
+
+template <typename Vector>
+std::size_t sum(const Vector& v) {
+  std::size_t result = 0;
+  for (const auto& p : v) {
+    result += unbox(p).value;
+  }
+  return result;
+}
+
+template <typename Vector, typename Make>
+void run(std::string_view name, std::size_t n, Make make) {
+  std::size_t iterations = 1'000'000 / (n + 1) + 1;
+  std::string prefix = std::string(name) + " n=" + std::to_string(n);
+
+  report(prefix + " build", measure_ns(iterations, [&] { do_not_optimize(build<Vector>(n, make)); }));
+
+  Vector v = build<Vector>(n, make);
+  report(prefix + " iterate", measure_ns(iterations, [&] { do_not_optimize(sum(v)); }));
+
+  report(prefix + " move", measure_ns(iterations, [&] {
+           Vector moved = std::move(v);
+           do_not_optimize(moved);
+           v = std::move(moved);
+         }));
+}
+
+} // namespace
+
+int main() {
+  using unique_vector = socow_vector<std::unique_ptr<payload>, SMALL_SIZE>;
+  using boxed_vector = socow_vector<boxed, SMALL_SIZE>;
+
+  for (std::size_t n : {3, 64, 4096}) {
+    run<unique_vector>("unique_ptr", n, [](std::size_t i) { return std::make_unique<payload>(i); });
+    run<boxed_vector>("shared_ptr<unique_ptr> (boxed)", n, [](std::size_t i) {
+      return std::make_shared<std::unique_ptr<payload>>(std::make_unique<payload>(i));
+    });
+  }
+}
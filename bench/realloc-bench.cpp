@@ -0,0 +1,53 @@
+#include "bench-utils.h"
+#include "heap-storage.h"
+#include "socow-vector.h"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace {
+
+template <typename Vector>
+void grow(std::size_t n) {
+  Vector v;
+  for (std::size_t i = 0; i != n; ++i) {
+    v.push_back(i);
+  }
+  do_not_optimize(v);
+}
+
+// Runs `grow` in a child process to report its own peak RSS
+template <typename Vector>
+void run(std::string_view name, std::size_t n) {
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid = fork();
+  if (pid == 0) {
+    grow<Vector>(n);
+    _exit(0);
+  }
+  int status = 0;
+  rusage usage{};
+  wait4(pid, &status, 0, &usage);
+  auto finish = std::chrono::steady_clock::now();
+
+  std::string prefix = std::string(name) + " " + std::to_string(n * sizeof(std::uint64_t) >> 20) + " MiB";
+  report(prefix + " push_back", std::chrono::duration<double, std::nano>(finish - start).count() / n);
+  std::cout << std::left << std::setw(48) << prefix + " peak RSS" << std::right << std::setw(12)
+            << usage.ru_maxrss / 1024 << " MiB\n";
+}
+
+} // namespace
+
+int main() {
+  for (std::size_t n : {std::size_t(1) << 22, std::size_t(1) << 25}) {
+    run<socow_vector<std::uint64_t, 4, realloc_heap_storage>>("realloc/mremap", n);
+    run<socow_vector<std::uint64_t, 4>>("allocate + copy", n);
+  }
+}
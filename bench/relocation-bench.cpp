@@ -0,0 +1,47 @@
+#include "bench-utils.h"
+#include "socow-vector.h"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+// Compare a default build with the NoExceptions preset: there reallocation moves elements whose move constructor
+// may throw instead of copying them, and the rollback code of the growth paths is compiled out.
+//   ci-extra/code-size.sh cmake-build-NoExceptions/relocation-bench grow_and_push_back
+
+namespace {
+
+// Unless the move constructor is noexcept, with exceptions the strong guarantee requires copying on reallocation
+template <bool NOTHROW_MOVE>
+struct text {
+  text(std::size_t i)
+      : value(std::to_string(i) + " long enough to defeat the small string optimization") {}
+
+  text(const text&) = default;
+
+  text(text&& other) noexcept(NOTHROW_MOVE)
+      : value(std::move(other.value)) {}
+
+  std::string value;
+};
+
+template <typename T>
+void run(std::string_view name, std::size_t n) {
+  report(std::string(name) + " n=" + std::to_string(n), measure_ns(100'000 / n + 1, [&] {
+           socow_vector<T, 4> v;
+           for (std::size_t i = 0; i != n; ++i) {
+             v.push_back(T(i));
+           }
+           do_not_optimize(v);
+         }));
+}
+
+} // namespace
+
+int main() {
+  std::cout << (SOCOW_EXCEPTIONS ? "exceptions enabled\n" : "exception-free mode\n");
+  for (std::size_t n : {16, 1024}) {
+    run<text<false>>("push_back, potentially throwing move", n);
+    run<text<true>>("push_back, noexcept move", n);
+  }
+}
@@ -0,0 +1,66 @@
+#include "bench-utils.h"
+#include "shared-count.h"
+#include "shared-data.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t COPIES = 1 << 22;
+
+template <typename Count>
+void copy_and_drop(const shared_data<int, Count>& data, std::size_t copies) {
+  for (std::size_t i = 0; i != copies; ++i) {
+    shared_data<int, Count> copy = data;
+    do_not_optimize(copy);
+  }
+}
+
+// Every thread copies and drops `COPIES / threads` times either its own object or one object shared by all
+template <typename Count>
+double copy_and_drop_ns(std::size_t threads, bool shared) {
+  shared_data<int, Count> common(0);
+  return measure_ns(1, [&] {
+           std::vector<std::thread> workers;
+           for (std::size_t t = 0; t != threads; ++t) {
+             workers.emplace_back([&] {
+               if (shared) {
+                 copy_and_drop(common, COPIES / threads);
+               } else {
+                 shared_data<int, Count> own(0);
+                 copy_and_drop(own, COPIES / threads);
+               }
+             });
+           }
+           for (std::thread& worker : workers) {
+             worker.join();
+           }
+         }) /
+         COPIES;
+}
+
+template <typename Count>
+void run(const std::string& name, std::size_t max_threads) {
+  shared_data<int, Count> data(0);
+  report(name + " copy + drop, one thread", measure_ns(COPIES, [&] { copy_and_drop(data, 1); }));
+  for (std::size_t threads = 2; threads <= max_threads; threads *= 2) {
+    std::string suffix = ", " + std::to_string(threads) + " threads";
+    report(name + " own objects" + suffix, copy_and_drop_ns<Count>(threads, false));
+    report(name + " one object" + suffix, copy_and_drop_ns<Count>(threads, true));
+  }
+}
+
+} // namespace
+
+// Copies of a shared object made and dropped by the thread that created it are the common case:
+// the biased count pays for them as little as the plain one, and as much as the atomic one otherwise
+int main() {
+  std::size_t max_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 2);
+  run<local_count>("local_count", 1);
+  run<atomic_count>("atomic_count", max_threads);
+  run<biased_count>("biased_count", max_threads);
+}
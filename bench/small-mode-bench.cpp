@@ -0,0 +1,143 @@
+#include "bench-utils.h"
+#include "socow-vector.h"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+// The entry points below are kept out of line so that `ci-extra/code-size.sh` can compare their sizes:
+//   ci-extra/code-size.sh cmake-build-Benchmark/small-mode-bench 'small_mode::'
+
+namespace {
+
+// Same layout as int, but not trivially copyable: takes the per-element loops
+struct boxed_int {
+  boxed_int(int value)
+      : value(value) {}
+
+  boxed_int(const boxed_int& other)
+      : value(other.value) {}
+
+  boxed_int& operator=(const boxed_int& other) {
+    value = other.value;
+    return *this;
+  }
+
+  int value;
+};
+
+constexpr std::size_t SMALL_SIZE = 8;
+
+using trivial_vector = socow_vector<int, SMALL_SIZE>;
+using loop_vector = socow_vector<boxed_int, SMALL_SIZE>;
+using pure_cow_vector = socow_vector<int, 0>;
+using one_inline_vector = socow_vector<int, 1>;
+
+} // namespace
+
+namespace small_mode {
+
+template <typename Vector>
+[[gnu::noinline]] Vector copy(const Vector& v) {
+  return v;
+}
+
+template <typename Vector>
+[[gnu::noinline]] Vector move(Vector& v) {
+  return std::move(v);
+}
+
+template <typename Vector>
+[[gnu::noinline]] void swap(Vector& a, Vector& b) {
+  a.swap(b);
+}
+
+template trivial_vector copy(const trivial_vector&);
+template loop_vector copy(const loop_vector&);
+template pure_cow_vector copy(const pure_cow_vector&);
+template one_inline_vector copy(const one_inline_vector&);
+
+template trivial_vector move(trivial_vector&);
+template loop_vector move(loop_vector&);
+template pure_cow_vector move(pure_cow_vector&);
+template one_inline_vector move(one_inline_vector&);
+
+template void swap(trivial_vector&, trivial_vector&);
+template void swap(loop_vector&, loop_vector&);
+template void swap(pure_cow_vector&, pure_cow_vector&);
+template void swap(one_inline_vector&, one_inline_vector&);
+
+// Element operations: with SMALL_SIZE 0 they have no inline branch
+template <typename Vector>
+[[gnu::noinline]] void push_back(Vector& v, int value) {
+  v.push_back(value);
+}
+
+template <typename Vector>
+[[gnu::noinline]] void pop_back(Vector& v) {
+  v.pop_back();
+}
+
+template <typename Vector>
+[[gnu::noinline]] int& subscript(Vector& v, std::size_t index) {
+  return v[index];
+}
+
+template <typename Vector>
+[[gnu::noinline]] std::size_t size(const Vector& v) {
+  return v.size();
+}
+
+template void push_back(pure_cow_vector&, int);
+template void push_back(one_inline_vector&, int);
+
+template void pop_back(pure_cow_vector&);
+template void pop_back(one_inline_vector&);
+
+template int& subscript(pure_cow_vector&, std::size_t);
+template int& subscript(one_inline_vector&, std::size_t);
+
+template std::size_t size(const pure_cow_vector&);
+template std::size_t size(const one_inline_vector&);
+
+} // namespace small_mode
+
+namespace {
+
+template <typename Vector>
+Vector build(std::size_t n) {
+  Vector v;
+  for (std::size_t i = 0; i != n; ++i) {
+    v.push_back(static_cast<int>(i));
+  }
+  return v;
+}
+
+template <typename Vector>
+void run(std::string_view name, std::size_t n) {
+  constexpr std::size_t iterations = 1'000'000;
+  std::string prefix = std::string(name) + " n=" + std::to_string(n);
+
+  Vector a = build<Vector>(n);
+  Vector b = build<Vector>(n == 0 ? 0 : n - 1);
+
+  report(prefix + " copy", measure_ns(iterations, [&] { do_not_optimize(small_mode::copy(a)); }));
+  report(prefix + " move", measure_ns(iterations, [&] {
+           Vector moved = small_mode::move(a);
+           a = small_mode::move(moved);
+         }));
+  report(prefix + " swap", measure_ns(iterations, [&] { small_mode::swap(a, b); }));
+}
+
+} // namespace
+
+int main() {
+  for (std::size_t n : {1, 4, 8}) {
+    run<trivial_vector>("memcpy small mode", n);
+    run<loop_vector>("per-element small mode", n);
+  }
+  for (std::size_t n : {0, 16}) {
+    run<pure_cow_vector>("SMALL_SIZE=0", n);
+    run<one_inline_vector>("SMALL_SIZE=1", n);
+  }
+}
@@ -0,0 +1,52 @@
+#include "bench-utils.h"
+#include "socow-soa-vector.h"
+#include "socow-vector.h"
+
+#include <cstddef>
+
+namespace {
+
+struct particle {
+  double x;
+  double y;
+  double z;
+  double mass;
+  double charge;
+  double velocity[3];
+};
+
+constexpr std::size_t N = 1 << 20;
+
+} // namespace
+
+// Sums one field of a million records: the columnar layout reads only that field from memory
+int main() {
+  constexpr std::size_t iterations = 20;
+
+  socow_vector<particle, 0> rows;
+  socow_soa_vector<0, double, double, double, double, double> columns;
+  rows.reserve(N);
+  columns.reserve(N);
+  for (std::size_t i = 0; i != N; ++i) {
+    double value = static_cast<double>(i % 1000);
+    rows.push_back(particle{value, value, value, value, value, {value, value, value}});
+    columns.push_back(value, value, value, value, value);
+  }
+
+  const auto& const_rows = rows;
+  const auto& const_columns = columns;
+  report("socow_vector<particle> sum of mass per record", measure_ns(iterations, [&] {
+           double sum = 0;
+           for (const particle& p : const_rows) {
+             sum += p.mass;
+           }
+           do_not_optimize(sum);
+         }) / N);
+  report("socow_soa_vector sum of mass per record", measure_ns(iterations, [&] {
+           double sum = 0;
+           for (double mass : const_columns.column<3>()) {
+             sum += mass;
+           }
+           do_not_optimize(sum);
+         }) / N);
+}
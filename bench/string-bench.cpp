@@ -0,0 +1,32 @@
+#include "bench-utils.h"
+#include "socow-string.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace {
+
+template <typename String>
+void run(std::string_view name, std::size_t length) {
+  constexpr std::size_t iterations = 1'000'000;
+  std::string prefix = std::string(name) + " length=" + std::to_string(length);
+
+  String s(length, 'a');
+  s += "needle";
+  report(prefix + " copy", measure_ns(iterations, [&] {
+           String copy = s;
+           do_not_optimize(copy);
+         }));
+  report(prefix + " find char", measure_ns(iterations, [&] { do_not_optimize(s.find('n')); }));
+  report(prefix + " find string", measure_ns(iterations, [&] { do_not_optimize(s.find("needle")); }));
+}
+
+} // namespace
+
+int main() {
+  for (std::size_t length : {8, 4096}) {
+    run<std::string>("std::string", length);
+    run<socow_string>("socow_string", length);
+  }
+}
@@ -0,0 +1,36 @@
+#include "bench-utils.h"
+#include "socow-vector.h"
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+int main() {
+  for (std::size_t n : {16, 4096, 1 << 20}) {
+    std::vector<int> source(n, 42);
+    std::size_t iterations = (1 << 24) / n + 1;
+    std::string suffix = " n=" + std::to_string(n);
+
+    report("push_back" + suffix, measure_ns(iterations, [&] {
+             socow_vector<int, 16> v;
+             for (int x : source) {
+               v.push_back(x);
+             }
+             do_not_optimize(v);
+           }));
+
+    report("append_uninitialized" + suffix, measure_ns(iterations, [&] {
+             socow_vector<int, 16> v;
+             v.append_uninitialized(n, [&](int* p) { std::memcpy(p, source.data(), n * sizeof(int)); });
+             do_not_optimize(v);
+           }));
+
+    report("resize_for_overwrite" + suffix, measure_ns(iterations, [&] {
+             socow_vector<int, 16> v;
+             v.resize_for_overwrite(n);
+             std::memcpy(v.data(), source.data(), n * sizeof(int));
+             do_not_optimize(v);
+           }));
+  }
+}
@@ -0,0 +1,13 @@
+#!/bin/bash
+set -euo pipefail
+
+# Prints the size in bytes of every function in BINARY whose demangled name contains PATTERN
+BINARY=$1
+PATTERN=${2:-socow_vector}
+
+nm -C -S -t d --size-sort --defined-only "$BINARY" |
+  awk -v pattern="$PATTERN" '$3 ~ /^[tTwW]$/ && index($0, pattern) {
+    size = $2 + 0
+    sub(/^[^ ]+ [^ ]+ [^ ]+ /, "")
+    printf "%8d  %s\n", size, $0
+  }'
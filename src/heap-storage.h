@@ -0,0 +1,253 @@
+#pragma once
+
+#include "socow-config.h"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// A storage provides raw memory for the buffer of a `vector`.
+// Every buffer gets its own default-constructed storage object, which lives as long as the buffer
+// and is moved along with it. Storages must be nothrow movable.
+//
+// void* allocate(std::size_t bytes, std::size_t alignment);
+// void deallocate(void* memory, std::size_t bytes, std::size_t alignment) noexcept;
+
+// A storage that can copy a buffer of trivially copyable elements lazily.
+// `clone` returns a copy of `bytes` bytes at `memory` (owned by `source`) or nullptr if it can't,
+// in which case the elements are copied as usual.
+// `prepare_write` is called before the elements of a uniquely owned buffer are modified in place.
+template <typename Storage>
+concept cloning_storage = requires(Storage& storage, const Storage& source, const void* memory, std::size_t bytes) {
+  { storage.clone(source, memory, bytes) } -> std::same_as<void*>;
+  storage.prepare_write();
+};
+
+// A storage that can move buffers of trivially copyable elements without copying them.
+// Such buffers are allocated with `allocate_relocatable` and freed with `deallocate_relocatable`.
+// `reallocate` returns the resized buffer with its contents preserved,
+// or nullptr if it can't resize it (the buffer is left intact then).
+template <typename Storage>
+concept reallocating_storage = requires(Storage& storage, void* memory, std::size_t bytes, std::size_t alignment) {
+  { storage.allocate_relocatable(bytes, alignment) } -> std::same_as<void*>;
+  { storage.reallocate(memory, bytes, bytes, alignment) } -> std::same_as<void*>;
+  storage.deallocate_relocatable(memory, bytes, alignment);
+};
+
+#ifdef __linux__
+// Size of a memory mapping that holds `bytes` bytes
+inline std::size_t mapping_size(std::size_t bytes) noexcept {
+  static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  return (bytes + page - 1) / page * page;
+}
+#endif
+
+// Heap allocation aligned to at least ALIGNMENT bytes (0 means the alignment of the element type).
+// If HUGE_PAGE_THRESHOLD is not 0, buffers of at least that many bytes are mapped at a 2 MiB boundary
+// and advised to be backed by transparent huge pages, also when `reallocate` moves them.
+// Buffers come from the global operator new unless REALLOCATE is set. Then buffers of trivially copyable elements
+// are relocatable: they come from `malloc` so that they can be grown with `realloc`, and the ones of at least
+// MMAP_THRESHOLD bytes are mapped directly so that `mremap` can move their pages. Such buffers bypass
+// a replaced operator new.
+template <std::size_t ALIGNMENT = 0, std::size_t HUGE_PAGE_THRESHOLD = 0, bool REALLOCATE = false>
+class basic_heap_storage {
+public:
+  // glibc stops serving large blocks with mmap once its dynamic threshold grows up to this size
+  static constexpr std::size_t MMAP_THRESHOLD = std::size_t(32) << 20;
+  static constexpr std::size_t HUGE_PAGE_SIZE = std::size_t(2) << 20;
+
+  void* allocate(std::size_t bytes, std::size_t alignment) {
+    if (huge(bytes)) {
+      return checked(map(bytes));
+    }
+    alignment = std::max(alignment, ALIGNMENT);
+    if constexpr (SOCOW_EXCEPTIONS) {
+      if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        return operator new(bytes, std::align_val_t(alignment));
+      }
+      return operator new(bytes);
+    } else {
+      if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        return checked(operator new(bytes, std::align_val_t(alignment), std::nothrow));
+      }
+      return checked(operator new(bytes, std::nothrow));
+    }
+  }
+
+  void deallocate(void* memory, std::size_t bytes, std::size_t alignment) noexcept {
+    if (huge(bytes)) {
+      unmap(memory, bytes);
+      return;
+    }
+    alignment = std::max(alignment, ALIGNMENT);
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      operator delete(memory, bytes, std::align_val_t(alignment));
+    } else {
+      operator delete(memory, bytes);
+    }
+  }
+
+  void* allocate_relocatable(std::size_t bytes, std::size_t alignment)
+    requires REALLOCATE
+  {
+    if (mapped(bytes)) {
+      return checked(map(bytes));
+    }
+    alignment = std::max(alignment, ALIGNMENT);
+    if (alignment > alignof(std::max_align_t)) {
+#ifdef _MSC_VER
+      // MSVC has no aligned_alloc, its aligned blocks must be released with _aligned_free
+      return checked(_aligned_malloc(std::max<std::size_t>(bytes, 1), alignment));
+#else
+      // aligned_alloc wants the size to be a multiple of the alignment
+      std::size_t size = (std::max<std::size_t>(bytes, 1) + alignment - 1) / alignment * alignment;
+      return checked(std::aligned_alloc(alignment, size));
+#endif
+    }
+    return checked(std::malloc(std::max<std::size_t>(bytes, 1)));
+  }
+
+  void* reallocate(void* memory, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment) noexcept
+    requires REALLOCATE
+  {
+    if (mapped(old_bytes) != mapped(new_bytes)) {
+      return nullptr;
+    }
+    if (!mapped(new_bytes)) {
+      // realloc doesn't preserve extended alignment
+      if (std::max(alignment, ALIGNMENT) > alignof(std::max_align_t)) {
+        return nullptr;
+      }
+      return std::realloc(memory, std::max<std::size_t>(new_bytes, 1));
+    }
+#ifdef __linux__
+    if (huge(new_bytes)) {
+      return remap_aligned(memory, mapping_size(old_bytes), mapping_size(new_bytes));
+    }
+    void* moved = ::mremap(memory, mapping_size(old_bytes), mapping_size(new_bytes), MREMAP_MAYMOVE);
+    return moved == MAP_FAILED ? nullptr : moved;
+#else
+    return nullptr;
+#endif
+  }
+
+  void deallocate_relocatable(void* memory, std::size_t bytes, [[maybe_unused]] std::size_t alignment) noexcept
+    requires REALLOCATE
+  {
+    if (mapped(bytes)) {
+      unmap(memory, bytes);
+      return;
+    }
+#ifdef _MSC_VER
+    if (std::max(alignment, ALIGNMENT) > alignof(std::max_align_t)) {
+      _aligned_free(memory);
+      return;
+    }
+#endif
+    std::free(memory);
+  }
+
+private:
+  static void* checked(void* memory) {
+    if (memory == nullptr) {
+      socow_throw(std::bad_alloc());
+    }
+    return memory;
+  }
+
+#ifdef __linux__
+  static bool huge(std::size_t bytes) noexcept {
+    return HUGE_PAGE_THRESHOLD != 0 && bytes >= HUGE_PAGE_THRESHOLD;
+  }
+
+  static bool mapped(std::size_t bytes) noexcept {
+    return bytes >= MMAP_THRESHOLD || huge(bytes);
+  }
+
+  // Mappings are page-aligned, huge ones are aligned to HUGE_PAGE_SIZE
+  static void* map(std::size_t bytes) noexcept {
+    std::size_t length = mapping_size(bytes);
+    if (!huge(bytes)) {
+      void* memory = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      return memory == MAP_FAILED ? nullptr : memory;
+    }
+    void* memory = map_aligned(length, PROT_READ | PROT_WRITE);
+    if (memory != nullptr) {
+      ::madvise(memory, length, MADV_HUGEPAGE);
+    }
+    return memory;
+  }
+
+  // Maps `length` bytes at a HUGE_PAGE_SIZE boundary by trimming a mapping that is HUGE_PAGE_SIZE longer
+  static void* map_aligned(std::size_t length, int protection) noexcept {
+    void* memory = ::mmap(nullptr, length + HUGE_PAGE_SIZE, protection, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+      return nullptr;
+    }
+    char* begin = static_cast<char*>(memory);
+    std::size_t head = (HUGE_PAGE_SIZE - reinterpret_cast<std::uintptr_t>(begin) % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+    if (head != 0) {
+      ::munmap(begin, head);
+    }
+    ::munmap(begin + head + length, HUGE_PAGE_SIZE - head);
+    return begin + head;
+  }
+
+  // MREMAP_MAYMOVE keeps only the page alignment. An aligned mapping is resized in place if it can be,
+  // otherwise it is moved over a range reserved at a HUGE_PAGE_SIZE boundary.
+  static void* remap_aligned(void* memory, std::size_t old_length, std::size_t new_length) noexcept {
+    void* moved = MAP_FAILED;
+    if (reinterpret_cast<std::uintptr_t>(memory) % HUGE_PAGE_SIZE == 0) {
+      moved = ::mremap(memory, old_length, new_length, 0);
+    }
+    if (moved == MAP_FAILED) {
+      void* target = map_aligned(new_length, PROT_NONE);
+      if (target == nullptr) {
+        return nullptr;
+      }
+      moved = ::mremap(memory, old_length, new_length, MREMAP_MAYMOVE | MREMAP_FIXED, target);
+      if (moved == MAP_FAILED) {
+        ::munmap(target, new_length);
+        return nullptr;
+      }
+    }
+    ::madvise(moved, new_length, MADV_HUGEPAGE);
+    return moved;
+  }
+
+  static void unmap(void* memory, std::size_t bytes) noexcept {
+    ::munmap(memory, mapping_size(bytes));
+  }
+#else
+  static bool huge(std::size_t) noexcept {
+    return false;
+  }
+
+  static bool mapped(std::size_t) noexcept {
+    return false;
+  }
+
+  static void* map(std::size_t) noexcept {
+    return nullptr;
+  }
+
+  static void unmap(void*, std::size_t) noexcept {}
+#endif
+};
+
+using heap_storage = basic_heap_storage<>;
+
+// Grows buffers of trivially copyable elements with realloc / mremap instead of allocating a new buffer and copying
+using realloc_heap_storage = basic_heap_storage<0, 0, true>;
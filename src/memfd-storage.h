@@ -0,0 +1,189 @@
+#pragma once
+
+#include "heap-storage.h"
+#include "socow-config.h"
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#ifdef __linux__
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Buffers of at least THRESHOLD bytes live in a memfd mapped into memory, smaller ones on the heap.
+// Copying a mapped buffer of trivially copyable elements maps the same file once more with MAP_PRIVATE,
+// so the kernel copies only the pages that actually get written.
+//
+// A new buffer is a writable MAP_SHARED mapping. Its first copy remaps it in place as MAP_PRIVATE,
+// after which the file is never written again. A private mapping is copied lazily only while none
+// of its pages were written, otherwise its elements are copied into a new memfd as usual.
+//
+// Copies of one buffer may be unshared on several threads at once: the remapping is done by the thread
+// that moves the mode out of `shared`, and a copy racing with it copies the elements instead.
+template <std::size_t THRESHOLD = (std::size_t(1) << 21)>
+class memfd_storage {
+public:
+  memfd_storage() noexcept = default;
+
+  memfd_storage(memfd_storage&& other) noexcept
+      : _fd(std::exchange(other._fd, -1))
+      , _mode(other._mode.load(std::memory_order_relaxed)) {}
+
+  memfd_storage& operator=(memfd_storage&& other) noexcept {
+    if (this != &other) {
+      close();
+      _fd = std::exchange(other._fd, -1);
+      _mode.store(other._mode.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    return *this;
+  }
+
+  ~memfd_storage() {
+    close();
+  }
+
+  void* allocate(std::size_t bytes, std::size_t alignment) {
+    if (bytes < THRESHOLD) {
+      return heap_storage().allocate(bytes, alignment);
+    }
+    int fd = ::memfd_create("socow-vector", MFD_CLOEXEC);
+    if (fd == -1) {
+      socow_throw(std::bad_alloc());
+    }
+    void* memory = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(mapping_size(bytes))) == 0) {
+      memory = ::mmap(nullptr, mapping_size(bytes), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (memory == MAP_FAILED) {
+      ::close(fd);
+      socow_throw(std::bad_alloc());
+    }
+    _fd = fd;
+    _mode.store(mode::shared, std::memory_order_relaxed);
+    return memory;
+  }
+
+  void deallocate(void* memory, std::size_t bytes, std::size_t alignment) noexcept {
+    if (_fd == -1) {
+      heap_storage().deallocate(memory, bytes, alignment);
+    } else {
+      ::munmap(memory, mapping_size(bytes));
+      close();
+    }
+  }
+
+  void* allocate_relocatable(std::size_t bytes, std::size_t alignment) {
+    if (bytes < THRESHOLD) {
+      return realloc_heap_storage().allocate_relocatable(bytes, alignment);
+    }
+    return allocate(bytes, alignment);
+  }
+
+  // Heap buffers are resized with realloc, writable mappings by resizing the file and remapping it
+  void* reallocate(void* memory, std::size_t old_bytes, std::size_t new_bytes, std::size_t alignment) noexcept {
+    if (_fd == -1) {
+      if (new_bytes >= THRESHOLD) {
+        return nullptr;
+      }
+      return realloc_heap_storage().reallocate(memory, old_bytes, new_bytes, alignment);
+    }
+    if (_mode.load(std::memory_order_relaxed) != mode::shared || new_bytes < THRESHOLD) {
+      return nullptr;
+    }
+    std::size_t old_length = mapping_size(old_bytes);
+    std::size_t new_length = mapping_size(new_bytes);
+    if (new_length > old_length && ::ftruncate(_fd, static_cast<off_t>(new_length)) != 0) {
+      return nullptr;
+    }
+    void* moved = ::mremap(memory, old_length, new_length, MREMAP_MAYMOVE);
+    if (moved == MAP_FAILED) {
+      return nullptr;
+    }
+    if (new_length < old_length) {
+      // Failing to shrink the file only leaves its tail unused
+      [[maybe_unused]] int result = ::ftruncate(_fd, static_cast<off_t>(new_length));
+    }
+    return moved;
+  }
+
+  void deallocate_relocatable(void* memory, std::size_t bytes, std::size_t alignment) noexcept {
+    if (_fd == -1) {
+      realloc_heap_storage().deallocate_relocatable(memory, bytes, alignment);
+    } else {
+      deallocate(memory, bytes, alignment);
+    }
+  }
+
+  void* clone(const memfd_storage& source, const void* memory, std::size_t bytes) noexcept {
+    if (source._fd == -1) {
+      return nullptr;
+    }
+    std::size_t length = mapping_size(bytes);
+    mode current = source._mode.load(std::memory_order_acquire);
+    if (current == mode::shared) {
+      // Only one thread remaps the source, the others find it `remapping` and give up
+      if (!source._mode.compare_exchange_strong(current, mode::remapping, std::memory_order_acquire)) {
+        return nullptr;
+      }
+      void* remapped =
+          ::mmap(const_cast<void*>(memory), length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, source._fd, 0);
+      if (remapped == MAP_FAILED) {
+        source._mode.store(mode::shared, std::memory_order_release);
+        return nullptr;
+      }
+      source._mode.store(mode::clean, std::memory_order_release);
+    } else if (current != mode::clean) {
+      return nullptr;
+    }
+
+    int fd = ::dup(source._fd);
+    if (fd == -1) {
+      return nullptr;
+    }
+    void* copy = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (copy == MAP_FAILED) {
+      ::close(fd);
+      return nullptr;
+    }
+    _fd = fd;
+    _mode.store(mode::clean, std::memory_order_relaxed);
+    return copy;
+  }
+
+  // Called by the only owner of the buffer, so no copy of it can be racing
+  void prepare_write() noexcept {
+    if (_mode.load(std::memory_order_relaxed) == mode::clean) {
+      _mode.store(mode::dirty, std::memory_order_relaxed);
+    }
+  }
+
+private:
+  enum class mode {
+    shared,    // MAP_SHARED, the file holds the elements
+    remapping, // a copy is remapping it as MAP_PRIVATE
+    clean,     // MAP_PRIVATE, no page was written since mapping
+    dirty,     // MAP_PRIVATE, some pages may differ from the file
+  };
+
+  int _fd = -1;
+  // Copies change the mode of their source, which may be shared between threads
+  mutable std::atomic<mode> _mode = mode::shared;
+
+  void close() noexcept {
+    if (_fd != -1) {
+      ::close(_fd);
+      _fd = -1;
+    }
+  }
+};
+
+#else
+
+// memfd is Linux-only, elsewhere buffers are always allocated on the heap
+template <std::size_t THRESHOLD = (std::size_t(1) << 21)>
+class memfd_storage : public heap_storage {};
+
+#endif
@@ -0,0 +1,436 @@
+#pragma once
+
+#include "heap-storage.h"
+#include "socow-config.h"
+
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Operations on the elements of a circular buffer of `capacity` slots, where the element with index `i`
+// lives in slot `(head + i) mod capacity`. They never allocate: the ones that add an element need a free slot.
+// Shared by the inline and the heap buffers of socow_deque.
+template <typename T>
+struct ring {
+  // O(1) nothrow
+  static std::size_t slot(std::size_t capacity, std::size_t head, std::size_t index) noexcept {
+    std::size_t i = head + index;
+    return i >= capacity ? i - capacity : i;
+  }
+
+  // O(1) strong
+  template <typename... Args>
+  static void emplace_back(T* data, std::size_t capacity, std::size_t head, std::size_t& size, Args&&... args) {
+    new (data + slot(capacity, head, size)) T(std::forward<Args>(args)...);
+    ++size;
+  }
+
+  // O(1) strong
+  template <typename... Args>
+  static void emplace_front(T* data, std::size_t capacity, std::size_t& head, std::size_t& size, Args&&... args) {
+    std::size_t new_head = head == 0 ? capacity - 1 : head - 1;
+    new (data + new_head) T(std::forward<Args>(args)...);
+    head = new_head;
+    ++size;
+  }
+
+  // O(1) nothrow
+  static void pop_back(T* data, std::size_t capacity, std::size_t head, std::size_t& size) noexcept {
+    --size;
+    data[slot(capacity, head, size)].~T();
+  }
+
+  // O(1) nothrow
+  static void pop_front(T* data, std::size_t capacity, std::size_t& head, std::size_t& size) noexcept {
+    data[head].~T();
+    head = slot(capacity, head, 1);
+    --size;
+  }
+
+  // O(min(index, size - index)) strong(nothrow move assignment)
+  // Inserts `value` before the element `index`, moving the elements on the shorter side of it by one slot
+  static void insert(
+      T* data,
+      std::size_t capacity,
+      std::size_t& head,
+      std::size_t& size,
+      std::size_t index,
+      T&& value
+  ) {
+    auto at = [&](std::size_t i) -> T& { return data[slot(capacity, head, i)]; };
+    if (index < size - index) {
+      if (index == 0) {
+        emplace_front(data, capacity, head, size, std::move(value));
+        return;
+      }
+      emplace_front(data, capacity, head, size, std::move(at(0)));
+      for (std::size_t i = 1; i != index; ++i) {
+        at(i) = std::move(at(i + 1));
+      }
+    } else {
+      if (index == size) {
+        emplace_back(data, capacity, head, size, std::move(value));
+        return;
+      }
+      emplace_back(data, capacity, head, size, std::move(at(size - 1)));
+      for (std::size_t i = size - 2; i != index; --i) {
+        at(i) = std::move(at(i - 1));
+      }
+    }
+    at(index) = std::move(value);
+  }
+
+  // O(min(first, size - last) + last - first) nothrow(move assignment)
+  // Closes the gap by moving the elements on the shorter side of it
+  static void erase(
+      T* data,
+      std::size_t capacity,
+      std::size_t& head,
+      std::size_t& size,
+      std::size_t first,
+      std::size_t last
+  ) {
+    std::size_t count = last - first;
+    if (count == 0) {
+      return;
+    }
+    auto at = [&](std::size_t i) -> T& { return data[slot(capacity, head, i)]; };
+    if (first < size - last) {
+      for (std::size_t i = first; i != 0; --i) {
+        at(i - 1 + count) = std::move(at(i - 1));
+      }
+      for (std::size_t i = 0; i != count; ++i) {
+        at(i).~T();
+      }
+      head = slot(capacity, head, count);
+    } else {
+      for (std::size_t i = last; i != size; ++i) {
+        at(i - count) = std::move(at(i));
+      }
+      for (std::size_t i = size - count; i != size; ++i) {
+        at(i).~T();
+      }
+    }
+    size -= count;
+  }
+
+  // O(size) nothrow
+  static void destroy(T* data, std::size_t capacity, std::size_t head, std::size_t size) noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (std::size_t i = 0; i != size; ++i) {
+        data[slot(capacity, head, i)].~T();
+      }
+    }
+  }
+};
+
+// Random access iterator over a circular buffer. The position is the slot of the element
+// without the wrap-around, so that iterators compare and subtract as plain indices.
+template <typename T>
+class ring_iterator {
+public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = std::remove_const_t<T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
+
+public:
+  ring_iterator() = default;
+
+  ring_iterator(T* data, std::size_t capacity, std::size_t position) noexcept
+      : _data(data)
+      , _capacity(capacity)
+      , _position(position) {}
+
+  operator ring_iterator<const T>() const noexcept
+    requires(!std::is_const_v<T>)
+  {
+    return {_data, _capacity, _position};
+  }
+
+  reference operator*() const noexcept {
+    return _data[_position >= _capacity ? _position - _capacity : _position];
+  }
+
+  pointer operator->() const noexcept {
+    return &**this;
+  }
+
+  reference operator[](difference_type n) const noexcept {
+    return *(*this + n);
+  }
+
+  ring_iterator& operator++() noexcept {
+    ++_position;
+    return *this;
+  }
+
+  ring_iterator operator++(int) noexcept {
+    ring_iterator result = *this;
+    ++_position;
+    return result;
+  }
+
+  ring_iterator& operator--() noexcept {
+    --_position;
+    return *this;
+  }
+
+  ring_iterator operator--(int) noexcept {
+    ring_iterator result = *this;
+    --_position;
+    return result;
+  }
+
+  ring_iterator& operator+=(difference_type n) noexcept {
+    _position += n;
+    return *this;
+  }
+
+  ring_iterator& operator-=(difference_type n) noexcept {
+    _position -= n;
+    return *this;
+  }
+
+  friend ring_iterator operator+(ring_iterator it, difference_type n) noexcept {
+    return it += n;
+  }
+
+  friend ring_iterator operator+(difference_type n, ring_iterator it) noexcept {
+    return it += n;
+  }
+
+  friend ring_iterator operator-(ring_iterator it, difference_type n) noexcept {
+    return it -= n;
+  }
+
+  friend difference_type operator-(const ring_iterator& lhs, const ring_iterator& rhs) noexcept {
+    return static_cast<difference_type>(lhs._position - rhs._position);
+  }
+
+  friend bool operator==(const ring_iterator& lhs, const ring_iterator& rhs) noexcept {
+    return lhs._position == rhs._position;
+  }
+
+  friend std::strong_ordering operator<=>(const ring_iterator& lhs, const ring_iterator& rhs) noexcept {
+    return lhs._position <=> rhs._position;
+  }
+
+private:
+  T* _data = nullptr;
+  std::size_t _capacity = 0;
+  std::size_t _position = 0;
+};
+
+// Heap buffer of socow_deque: a circular buffer that grows geometrically like `vector`.
+// `Storage` provides the raw memory, see heap-storage.h.
+template <typename T, typename Storage = heap_storage>
+class ring_buffer {
+public:
+  using value_type = T;
+
+  using iterator = ring_iterator<T>;
+  using const_iterator = ring_iterator<const T>;
+
+public:
+  // O(1) nothrow
+  ring_buffer() noexcept
+      : _data(nullptr)
+      , _capacity(0)
+      , _head(0)
+      , _size(0) {}
+
+  // O(N) strong
+  ring_buffer(const ring_buffer& other)
+    requires std::copy_constructible<T>
+      : ring_buffer(other.begin(), other.size(), other.size()) {}
+
+  // O(N) strong
+  // Constructs `count` elements from `first` (moves them with a move iterator) in a buffer of `capacity` slots
+  template <std::input_iterator It>
+  ring_buffer(It first, std::size_t count, std::size_t capacity)
+      : _data(nullptr)
+      , _capacity(capacity)
+      , _head(0)
+      , _size(0) {
+    if (_capacity == 0) {
+      return;
+    }
+    _data = static_cast<T*>(_storage.allocate(sizeof(T) * _capacity, alignof(T)));
+    SOCOW_TRY {
+      for (; _size != count; ++_size, ++first) {
+        new (_data + _size) T(*first);
+      }
+    }
+    SOCOW_CATCH_ALL {
+      release();
+      SOCOW_RETHROW;
+    }
+  }
+
+  // O(1) nothrow
+  ring_buffer(ring_buffer&& other) noexcept
+      : _data(std::exchange(other._data, nullptr))
+      , _capacity(std::exchange(other._capacity, 0))
+      , _head(std::exchange(other._head, 0))
+      , _size(std::exchange(other._size, 0))
+      , _storage(std::move(other._storage)) {}
+
+  // O(N) strong
+  ring_buffer& operator=(const ring_buffer& other)
+    requires std::copy_constructible<T>
+  {
+    if (this != &other) {
+      ring_buffer(other).swap(*this);
+    }
+    return *this;
+  }
+
+  // O(1) nothrow
+  ring_buffer& operator=(ring_buffer&& other) noexcept {
+    if (this != &other) {
+      swap(other);
+    }
+    return *this;
+  }
+
+  // O(N) nothrow
+  ~ring_buffer() noexcept {
+    release();
+  }
+
+  // O(1) nothrow
+  std::size_t size() const noexcept {
+    return _size;
+  }
+
+  // O(1) nothrow
+  std::size_t capacity() const noexcept {
+    return _capacity;
+  }
+
+  // O(1) nothrow
+  T& operator[](std::size_t index) noexcept {
+    return _data[ring<T>::slot(_capacity, _head, index)];
+  }
+
+  // O(1) nothrow
+  const T& operator[](std::size_t index) const noexcept {
+    return _data[ring<T>::slot(_capacity, _head, index)];
+  }
+
+  // O(1) nothrow
+  iterator begin() noexcept {
+    return {_data, _capacity, _head};
+  }
+
+  // O(1) nothrow
+  iterator end() noexcept {
+    return {_data, _capacity, _head + _size};
+  }
+
+  // O(1) nothrow
+  const_iterator begin() const noexcept {
+    return {_data, _capacity, _head};
+  }
+
+  // O(1) nothrow
+  const_iterator end() const noexcept {
+    return {_data, _capacity, _head + _size};
+  }
+
+  // O(1)* strong
+  // `value` must not refer to an element of the buffer
+  void push_back(T&& value) {
+    if (_size == _capacity) [[unlikely]] {
+      change_capacity(_capacity * 2 + 1);
+    }
+    ring<T>::emplace_back(_data, _capacity, _head, _size, std::move(value));
+  }
+
+  // O(1)* strong
+  // `value` must not refer to an element of the buffer
+  void push_front(T&& value) {
+    if (_size == _capacity) [[unlikely]] {
+      change_capacity(_capacity * 2 + 1);
+    }
+    ring<T>::emplace_front(_data, _capacity, _head, _size, std::move(value));
+  }
+
+  // O(1) nothrow
+  void pop_back() noexcept {
+    ring<T>::pop_back(_data, _capacity, _head, _size);
+  }
+
+  // O(1) nothrow
+  void pop_front() noexcept {
+    ring<T>::pop_front(_data, _capacity, _head, _size);
+  }
+
+  // O(min(index, size - index))* strong(nothrow move assignment)
+  // `value` must not refer to an element of the buffer
+  void insert(std::size_t index, T&& value) {
+    if (_size == _capacity) [[unlikely]] {
+      change_capacity(_capacity * 2 + 1);
+    }
+    ring<T>::insert(_data, _capacity, _head, _size, index, std::move(value));
+  }
+
+  // O(min(first, size - last) + last - first) nothrow(move assignment)
+  void erase(std::size_t first, std::size_t last) {
+    ring<T>::erase(_data, _capacity, _head, _size, first, last);
+  }
+
+  // O(N) strong
+  void reserve(std::size_t new_capacity) {
+    if (new_capacity > _capacity) {
+      change_capacity(new_capacity);
+    }
+  }
+
+  // O(N) nothrow
+  void clear() noexcept {
+    ring<T>::destroy(_data, _capacity, _head, _size);
+    _head = 0;
+    _size = 0;
+  }
+
+  // O(1) nothrow
+  void swap(ring_buffer& other) noexcept {
+    using std::swap;
+    swap(_data, other._data);
+    swap(_capacity, other._capacity);
+    swap(_head, other._head);
+    swap(_size, other._size);
+    swap(_storage, other._storage);
+  }
+
+private:
+  T* _data;
+  std::size_t _capacity;
+  std::size_t _head;
+  std::size_t _size;
+  SOCOW_NO_UNIQUE_ADDRESS Storage _storage;
+
+  void release() noexcept {
+    ring<T>::destroy(_data, _capacity, _head, _size);
+    if (_data != nullptr) {
+      _storage.deallocate(_data, sizeof(T) * _capacity, alignof(T));
+    }
+  }
+
+  // O(N) strong
+  // Moves the elements to the start of a new buffer, unless a throwing move would break the strong guarantee
+  SOCOW_COLD void change_capacity(std::size_t new_capacity) {
+    if constexpr (std::is_nothrow_move_constructible_v<T> || !std::copy_constructible<T> || !SOCOW_EXCEPTIONS) {
+      ring_buffer(std::make_move_iterator(begin()), _size, new_capacity).swap(*this);
+    } else {
+      ring_buffer(std::as_const(*this).begin(), _size, new_capacity).swap(*this);
+    }
+  }
+};
@@ -0,0 +1,338 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+// Reference counts of the control block of shared_data. A new count holds one reference.
+//
+// void acquire() noexcept;
+// void release(socow_dispose dispose, void* block) noexcept;  // calls `dispose(block)` once the last one is gone
+// std::size_t use_count() const noexcept;
+//
+// `release` may defer the disposal to another thread, hence the type-erased callback.
+using socow_dispose = void (*)(void* block) noexcept;
+
+// Not thread-safe: copies of one object must stay on one thread
+class local_count {
+public:
+  void acquire() noexcept {
+    ++_count;
+  }
+
+  void release(socow_dispose dispose, void* block) noexcept {
+    if (--_count == 0) {
+      dispose(block);
+    }
+  }
+
+  std::size_t use_count() const noexcept {
+    return _count;
+  }
+
+private:
+  std::size_t _count = 1;
+};
+
+// Every operation is an atomic read-modify-write
+class atomic_count {
+public:
+  void acquire() noexcept {
+    _count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void release(socow_dispose dispose, void* block) noexcept {
+    if (_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      dispose(block);
+    }
+  }
+
+  std::size_t use_count() const noexcept {
+    return _count.load(std::memory_order_acquire);
+  }
+
+private:
+  std::atomic<std::size_t> _count = 1;
+};
+
+class biased_count;
+
+namespace socow_detail {
+
+// Ids of threads that own counts start from 1: 0 marks a count without an owner,
+// and an id that no count ever stores belongs to threads that haven't registered (or already left)
+inline constexpr std::uint32_t NO_OWNER = 0;
+inline constexpr std::uint32_t UNREGISTERED = ~std::uint32_t(0);
+
+inline thread_local std::uint32_t biased_thread_id = UNREGISTERED;
+
+// A release that has to be finished by the owner of the count. A count is queued at most once,
+// so the entry lives in the count itself and queueing never allocates.
+struct queued_release {
+  biased_count* next = nullptr;
+  socow_dispose dispose = nullptr;
+  void* block = nullptr;
+};
+
+// Registered threads form a list guarded by one mutex, which also guards their queues:
+// it is taken only when a count changes hands between threads
+struct biased_thread {
+  std::uint32_t id = NO_OWNER;
+  biased_thread* next = nullptr;
+  biased_count* queue = nullptr;
+  std::atomic<bool> pending = false;
+
+  ~biased_thread();
+};
+
+struct biased_registry {
+  std::mutex lock;
+  biased_thread* threads = nullptr;
+  std::uint32_t last_id = NO_OWNER;
+};
+
+// Never destroyed: counts of objects with static storage duration may be released after it would have been
+inline biased_registry& registry() noexcept {
+  static biased_registry* instance = new biased_registry;
+  return *instance;
+}
+
+inline thread_local biased_thread* current_thread = nullptr;
+inline thread_local bool retired = false;
+
+std::uint32_t register_thread() noexcept;
+void merge_queued_releases() noexcept;
+void merge_all(biased_count* queue) noexcept;
+
+} // namespace socow_detail
+
+// Biased reference counting: the thread that created the count (its owner) changes a plain counter,
+// which costs no more than a single-threaded count, while other threads change a separate atomic one.
+// The total is the sum of both. When the owner drops its last reference, or leaves, the counts are merged
+// and from then on every thread uses the atomic counter.
+// If the atomic counter of an unmerged count goes negative, only the owner knows whether the total reached zero:
+// the count is queued, and the owner merges it the next time it creates a count, calls socow_merge_queued_releases()
+// or exits. Until then the block stays allocated.
+class biased_count {
+public:
+  biased_count() noexcept
+      : _owner(current_owner())
+      , _local(1)
+      , _shared(0) {
+    if (_owner.load(std::memory_order_relaxed) == socow_detail::NO_OWNER) {
+      // Created by an exiting thread, which can't merge anything anymore
+      _local.store(0, std::memory_order_relaxed);
+      _shared.store(ONE | MERGED, std::memory_order_relaxed);
+    }
+  }
+
+  biased_count(const biased_count&) = delete;
+  biased_count& operator=(const biased_count&) = delete;
+
+  void acquire() noexcept {
+    if (owned()) [[likely]] {
+      // Only the owner writes the plain counter: a load and a store, without a locked instruction
+      _local.store(_local.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    } else {
+      _shared.fetch_add(ONE, std::memory_order_relaxed);
+    }
+  }
+
+  void release(socow_dispose dispose, void* block) noexcept {
+    if (owned()) [[likely]] {
+      std::uint32_t local = _local.load(std::memory_order_relaxed) - 1;
+      _local.store(local, std::memory_order_release);
+      if (local == 0) [[unlikely]] {
+        release_last_local(dispose, block);
+      }
+    } else {
+      release_shared(dispose, block);
+    }
+  }
+
+  // The plain counter is read first: if it is already cleared by a merge, the atomic one has the merged value
+  std::size_t use_count() const noexcept {
+    std::int64_t local = _local.load(std::memory_order_acquire);
+    std::int64_t shared = _shared.load(std::memory_order_acquire);
+    return static_cast<std::size_t>(local + (shared >> FLAG_BITS));
+  }
+
+  // Folds the plain counter into the atomic one. Called by the owner, or by any thread once the owner has left.
+  // The plain counter is cleared only after the atomic one took it over, so that `use_count` never comes out low.
+  void merge(socow_dispose dispose, void* block) noexcept {
+    std::int64_t local = _local.load(std::memory_order_relaxed);
+    _owner.store(socow_detail::NO_OWNER, std::memory_order_relaxed);
+    std::int64_t shared = _shared.load(std::memory_order_relaxed);
+    std::int64_t merged;
+    do {
+      merged = ((shared & ~QUEUED) + local * ONE) | MERGED;
+    } while (!_shared.compare_exchange_weak(shared, merged, std::memory_order_acq_rel, std::memory_order_relaxed));
+    _local.store(0, std::memory_order_release);
+    if (merged == MERGED) {
+      dispose(block);
+    }
+  }
+
+private:
+  // The atomic counter keeps two flags in its low bits
+  static constexpr int FLAG_BITS = 2;
+  static constexpr std::int64_t QUEUED = 1;
+  static constexpr std::int64_t MERGED = 2;
+  static constexpr std::int64_t ONE = std::int64_t(1) << FLAG_BITS;
+
+  std::atomic<std::uint32_t> _owner;
+  std::atomic<std::uint32_t> _local;
+  std::atomic<std::int64_t> _shared;
+  socow_detail::queued_release _queued;
+
+  friend void socow_detail::merge_all(biased_count* queue) noexcept;
+
+  static std::uint32_t current_owner() noexcept {
+    std::uint32_t id = socow_detail::biased_thread_id;
+    if (id == socow_detail::UNREGISTERED) [[unlikely]] {
+      return socow_detail::register_thread();
+    }
+    if (socow_detail::current_thread->pending.load(std::memory_order_relaxed)) [[unlikely]] {
+      socow_detail::merge_queued_releases();
+    }
+    return id;
+  }
+
+  bool owned() const noexcept {
+    return _owner.load(std::memory_order_relaxed) == socow_detail::biased_thread_id;
+  }
+
+  // Nobody else can hold a reference if the atomic counter is zero: no merge is needed
+  void release_last_local(socow_dispose dispose, void* block) noexcept {
+    std::int64_t shared = _shared.load(std::memory_order_acquire);
+    if (shared == 0) {
+      dispose(block);
+      return;
+    }
+    _owner.store(socow_detail::NO_OWNER, std::memory_order_relaxed);
+    std::int64_t merged;
+    do {
+      merged = shared | MERGED;
+    } while (!_shared.compare_exchange_weak(shared, merged, std::memory_order_acq_rel, std::memory_order_acquire));
+    // A queued count is disposed of by the owner when it merges its queue
+    if (merged == MERGED) {
+      dispose(block);
+    }
+  }
+
+  void release_shared(socow_dispose dispose, void* block) noexcept {
+    std::int64_t shared = _shared.load(std::memory_order_relaxed);
+    std::int64_t next;
+    bool queue;
+    do {
+      next = shared - ONE;
+      queue = (shared & (QUEUED | MERGED)) == 0 && next < 0;
+      if (queue) {
+        next |= QUEUED;
+      }
+    } while (!_shared.compare_exchange_weak(shared, next, std::memory_order_acq_rel, std::memory_order_relaxed));
+    if (queue) {
+      enqueue(dispose, block);
+    } else if (next == MERGED) {
+      dispose(block);
+    }
+  }
+
+  void enqueue(socow_dispose dispose, void* block) noexcept;
+};
+
+inline void biased_count::enqueue(socow_dispose dispose, void* block) noexcept {
+  std::uint32_t owner = _owner.load(std::memory_order_relaxed);
+  socow_detail::biased_registry& registry = socow_detail::registry();
+  {
+    std::lock_guard guard(registry.lock);
+    for (socow_detail::biased_thread* thread = registry.threads; thread != nullptr; thread = thread->next) {
+      if (thread->id == owner) {
+        _queued = {thread->queue, dispose, block};
+        thread->queue = this;
+        thread->pending.store(true, std::memory_order_relaxed);
+        return;
+      }
+    }
+  }
+  // The owner has left: its last write to the plain counter happened before it unregistered under the mutex
+  merge(dispose, block);
+}
+
+namespace socow_detail {
+
+inline std::uint32_t register_thread() noexcept {
+  if (retired) {
+    return NO_OWNER;
+  }
+  static thread_local biased_thread self;
+  biased_registry& instance = registry();
+  {
+    std::lock_guard guard(instance.lock);
+    self.id = ++instance.last_id;
+    self.next = std::exchange(instance.threads, &self);
+  }
+  current_thread = &self;
+  biased_thread_id = self.id;
+  return self.id;
+}
+
+// The entry is read before the merge, which may dispose of the count
+inline void merge_all(biased_count* queue) noexcept {
+  while (queue != nullptr) {
+    queued_release entry = queue->_queued;
+    queue->merge(entry.dispose, entry.block);
+    queue = entry.next;
+  }
+}
+
+inline void merge_queued_releases() noexcept {
+  biased_thread* self = current_thread;
+  if (self == nullptr) {
+    return;
+  }
+  biased_count* queue;
+  {
+    std::lock_guard guard(registry().lock);
+    queue = std::exchange(self->queue, nullptr);
+    self->pending.store(false, std::memory_order_relaxed);
+  }
+  merge_all(queue);
+}
+
+// Counts still owned by the thread are merged by whichever thread finds them queued afterwards
+inline biased_thread::~biased_thread() {
+  biased_count* rest;
+  {
+    std::lock_guard guard(registry().lock);
+    biased_thread** link = &registry().threads;
+    while (*link != this) {
+      link = &(*link)->next;
+    }
+    *link = next;
+    rest = std::exchange(queue, nullptr);
+    // From now on the thread changes only atomic counters, so others may merge the counts it owned
+    retired = true;
+    current_thread = nullptr;
+    biased_thread_id = UNREGISTERED;
+  }
+  merge_all(rest);
+}
+
+} // namespace socow_detail
+
+// Merges the counts other threads have queued for the calling thread, disposing of those no longer referenced.
+// Threads that keep copies of long-lived objects but rarely create new ones can call it periodically.
+inline void socow_merge_queued_releases() noexcept {
+  socow_detail::merge_queued_releases();
+}
+
+// Counts are thread-safe by default. Programs that never share copies between threads
+// may define SOCOW_SINGLE_THREADED to get the plain count back.
+#ifdef SOCOW_SINGLE_THREADED
+using socow_shared_count = local_count;
+#else
+using socow_shared_count = biased_count;
+#endif
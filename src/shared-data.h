@@ -1,30 +1,41 @@
 #pragma once
 
+#include "shared-count.h"
+#include "socow-config.h"
+
 #include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 
-template <typename T>
+// The reference count and the object share one allocation. `Count` is one of the counts in shared-count.h.
+// The counts are not usable in constant expressions, so during constant evaluation the control block keeps
+// a plain counter in their place. Such an object must be destroyed before the evaluation ends, as any other
+// transient allocation: shared heap buffers can be used while computing a constant, but can't be a part of one.
+template <typename T, typename Count = socow_shared_count>
 class shared_data {
 public:
   using value_type = T;
   using pointer = T*;
   using reference = T&;
 
-  template <typename U, std::size_t SMALL_SIZE>
-  friend class socow_vector;
-
 public:
-  shared_data()
-      : _data(nullptr)
-      , _count(nullptr) {}
-
-  shared_data(const shared_data& other)
-      : _data(other._data)
-      , _count(other._count) {
-    ++*_count;
+  constexpr shared_data()
+      : _control(nullptr) {}
+
+  constexpr shared_data(const shared_data& other)
+      : _control(other._control) {
+    if (_control != nullptr) {
+      if (std::is_constant_evaluated()) {
+        ++_control->constant_count;
+      } else {
+        _control->count.acquire();
+      }
+    }
   }
 
-  shared_data& operator=(const shared_data& other) noexcept {
+  constexpr shared_data& operator=(const shared_data& other) noexcept {
     if (this != &other) {
       shared_data copy(other);
       swap(*this, copy);
@@ -32,14 +43,12 @@ public:
     return *this;
   }
 
-  shared_data(shared_data&& other) noexcept
-      : _data(other._data)
-      , _count(other._count) {
-    other._data = nullptr;
-    other._count = nullptr;
+  constexpr shared_data(shared_data&& other) noexcept
+      : _control(other._control) {
+    other._control = nullptr;
   }
 
-  shared_data& operator=(shared_data&& other) noexcept {
+  constexpr shared_data& operator=(shared_data&& other) noexcept {
     if (this != &other) {
       shared_data empty;
       swap(*this, empty);
@@ -48,37 +57,97 @@ public:
     return *this;
   }
 
-  ~shared_data() {
-    if (_count != nullptr && !--*_count) {
-      delete _data;
-      delete _count;
+  constexpr ~shared_data() {
+    if (_control != nullptr) {
+      if (std::is_constant_evaluated()) {
+        if (--_control->constant_count == 0) {
+          delete _control;
+        }
+      } else {
+        _control->count.release(&dispose, _control);
+      }
     }
   }
 
+  // Constructs the object from `args`; a single non-const shared_data argument is still a copy
   template <typename... Args>
-  explicit shared_data(Args&&... args)
-      : _data(new T(std::forward<Args>(args)...))
-      , _count(new std::size_t(1)) {}
+    requires(!(sizeof...(Args) == 1 && (std::is_same_v<std::remove_cvref_t<Args>, shared_data> && ...)))
+  explicit constexpr shared_data(Args&&... args)
+      : _control(create(std::forward<Args>(args)...)) {}
+
+  constexpr reference operator*() const {
+    return _control->value;
+  }
 
-  reference operator*() const {
-    return *_data;
+  constexpr pointer operator->() const {
+    return &_control->value;
   }
 
-  pointer operator->() const {
-    return _data;
+  constexpr std::size_t use_count() const {
+    if (std::is_constant_evaluated()) {
+      return _control->constant_count;
+    }
+    return _control->count.use_count();
   }
 
-  std::size_t use_count() const {
-    return *_count;
+  // Default-constructed and moved-from objects own nothing
+  explicit constexpr operator bool() const noexcept {
+    return _control != nullptr;
   }
 
-  friend void swap(shared_data& lhs, shared_data& rhs) {
+  // Bytes allocated for the count and the object
+  static constexpr std::size_t control_block_size() noexcept {
+    return sizeof(control_block);
+  }
+
+  friend constexpr void swap(shared_data& lhs, shared_data& rhs) {
     using std::swap;
-    swap(lhs._data, rhs._data);
-    swap(lhs._count, rhs._count);
+    swap(lhs._control, rhs._control);
   }
 
 private:
-  pointer _data = nullptr;
-  std::size_t* _count = nullptr;
+  // During constant evaluation `constant_count` is the active member of the union, otherwise `count`
+  struct control_block {
+    template <typename... Args>
+    explicit constexpr control_block(Args&&... args)
+        : value(std::forward<Args>(args)...) {
+      if (std::is_constant_evaluated()) {
+        std::construct_at(&constant_count, 1);
+      } else {
+        std::construct_at(&count);
+      }
+    }
+
+    constexpr ~control_block() {
+      if (!std::is_constant_evaluated()) {
+        std::destroy_at(&count);
+      }
+    }
+
+    union {
+      Count count;
+      std::size_t constant_count;
+    };
+    T value;
+  };
+
+  control_block* _control = nullptr;
+
+  static void dispose(void* block) noexcept {
+    delete static_cast<control_block*>(block);
+  }
+
+  // In exception-free mode a failed `new` would terminate without reaching the failure handler
+  template <typename... Args>
+  static constexpr control_block* create(Args&&... args) {
+    if (std::is_constant_evaluated() || SOCOW_EXCEPTIONS) {
+      return new control_block(std::forward<Args>(args)...);
+    } else {
+      control_block* result = new (std::nothrow) control_block(std::forward<Args>(args)...);
+      if (result == nullptr) {
+        socow_throw(std::bad_alloc());
+      }
+      return result;
+    }
+  }
 };
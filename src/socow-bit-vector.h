@@ -0,0 +1,824 @@
+#pragma once
+
+#include "heap-storage.h"
+#include "shared-data.h"
+#include "socow-vector.h"
+#include "vector.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+// Heap buffer of a bit-packed socow_vector: the words and the number of bits in use.
+// There are exactly as many words as the bits need, and the bits past `size` in the last word are zero,
+// so that whole words can be counted, combined and compared.
+template <typename Storage>
+struct socow_bit_buffer {
+  std::size_t size = 0;
+  vector<std::uint64_t, Storage> words;
+};
+
+// A bool taking a whole byte. socow_vector<socow_byte_bool> stores flags unpacked, for containers that need
+// contiguous elements or real bool references, which the bit-packed socow_vector<bool> can't give.
+struct socow_byte_bool {
+  bool value;
+
+  socow_byte_bool() = default;
+
+  constexpr socow_byte_bool(bool value) noexcept
+      : value(value) {}
+
+  constexpr operator bool() const noexcept {
+    return value;
+  }
+};
+
+// Element type a container stores for T in a socow_vector when it needs T& to the elements
+template <typename T>
+using socow_unpacked_t = std::conditional_t<std::is_same_v<T, bool>, socow_byte_bool, T>;
+
+// The element as a T&, unwrapping socow_byte_bool
+template <typename T>
+constexpr T& socow_unpack(T& value) noexcept {
+  return value;
+}
+
+constexpr bool& socow_unpack(socow_byte_bool& value) noexcept {
+  return value.value;
+}
+
+constexpr const bool& socow_unpack(const socow_byte_bool& value) noexcept {
+  return value.value;
+}
+
+// Bit-packed socow_vector<bool>: up to SMALL_SIZE bits are stored inline in 64-bit words, and copies of larger vectors
+// share a heap buffer of words, copied on write like the buffer of any other socow_vector.
+// Elements are accessed through proxy references. `count`, `find_first` and the bitwise operators
+// work a whole word at a time.
+template <std::size_t SMALL_SIZE, typename Storage>
+class socow_vector<bool, SMALL_SIZE, Storage> {
+public:
+  using word = std::uint64_t;
+  static constexpr std::size_t WORD_BITS = 64;
+
+  using value_type = bool;
+
+  class reference;
+  using const_reference = bool;
+
+  template <bool CONST>
+  class basic_iterator;
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+  // Refers to one bit of a word
+  class reference {
+  public:
+    constexpr reference(const reference&) noexcept = default;
+
+    constexpr operator bool() const noexcept {
+      return (*_word & _mask) != 0;
+    }
+
+    constexpr reference& operator=(bool value) noexcept {
+      if (value) {
+        *_word |= _mask;
+      } else {
+        *_word &= ~_mask;
+      }
+      return *this;
+    }
+
+    constexpr reference& operator=(const reference& other) noexcept {
+      return *this = static_cast<bool>(other);
+    }
+
+    constexpr void flip() noexcept {
+      *_word ^= _mask;
+    }
+
+    friend constexpr void swap(reference lhs, reference rhs) noexcept {
+      bool value = lhs;
+      lhs = static_cast<bool>(rhs);
+      rhs = value;
+    }
+
+  private:
+    friend class socow_vector;
+    template <bool>
+    friend class basic_iterator;
+
+    constexpr reference(word* w, std::size_t bit) noexcept
+        : _word(w)
+        , _mask(word(1) << bit) {}
+
+    word* _word;
+    word _mask;
+  };
+
+  template <bool CONST>
+  class basic_iterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = bool;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<CONST, bool, typename socow_vector::reference>;
+    using pointer = void;
+
+  public:
+    constexpr basic_iterator() noexcept = default;
+
+    constexpr basic_iterator(const basic_iterator&) noexcept = default;
+
+    constexpr basic_iterator(const basic_iterator<false>& other) noexcept
+      requires CONST
+        : _words(other._words)
+        , _index(other._index) {}
+
+    constexpr reference operator*() const noexcept {
+      if constexpr (CONST) {
+        return test(_words, _index);
+      } else {
+        return reference(_words + _index / WORD_BITS, _index % WORD_BITS);
+      }
+    }
+
+    constexpr reference operator[](difference_type n) const noexcept {
+      return *(*this + n);
+    }
+
+    constexpr basic_iterator& operator++() noexcept {
+      ++_index;
+      return *this;
+    }
+
+    constexpr basic_iterator operator++(int) noexcept {
+      basic_iterator result = *this;
+      ++_index;
+      return result;
+    }
+
+    constexpr basic_iterator& operator--() noexcept {
+      --_index;
+      return *this;
+    }
+
+    constexpr basic_iterator operator--(int) noexcept {
+      basic_iterator result = *this;
+      --_index;
+      return result;
+    }
+
+    constexpr basic_iterator& operator+=(difference_type n) noexcept {
+      _index += n;
+      return *this;
+    }
+
+    constexpr basic_iterator& operator-=(difference_type n) noexcept {
+      _index -= n;
+      return *this;
+    }
+
+    friend constexpr basic_iterator operator+(basic_iterator it, difference_type n) noexcept {
+      return it += n;
+    }
+
+    friend constexpr basic_iterator operator+(difference_type n, basic_iterator it) noexcept {
+      return it += n;
+    }
+
+    friend constexpr basic_iterator operator-(basic_iterator it, difference_type n) noexcept {
+      return it -= n;
+    }
+
+    friend constexpr difference_type operator-(const basic_iterator& lhs, const basic_iterator& rhs) noexcept {
+      return static_cast<difference_type>(lhs._index) - static_cast<difference_type>(rhs._index);
+    }
+
+    friend constexpr bool operator==(const basic_iterator& lhs, const basic_iterator& rhs) noexcept {
+      return lhs._index == rhs._index;
+    }
+
+    friend constexpr std::strong_ordering operator<=>(const basic_iterator& lhs, const basic_iterator& rhs) noexcept {
+      return lhs._index <=> rhs._index;
+    }
+
+  private:
+    friend class socow_vector;
+    friend class basic_iterator<!CONST>;
+
+    using word_pointer = std::conditional_t<CONST, const word*, word*>;
+
+    constexpr basic_iterator(word_pointer words, std::size_t index) noexcept
+        : _words(words)
+        , _index(index) {}
+
+    word_pointer _words = nullptr;
+    std::size_t _index = 0;
+  };
+
+public:
+  constexpr socow_vector() noexcept
+      : _size(0) {
+    begin_static();
+  }
+
+  // O(N / WORD_BITS)
+  constexpr socow_vector(std::size_t count, bool value)
+      : socow_vector() {
+    resize(count, value);
+  }
+
+  // O(SMALL_SIZE / WORD_BITS) / O(1); nothrow / nothrow
+  constexpr socow_vector(const socow_vector& other) noexcept
+      : _size(other._size) {
+    if (other.small_object()) {
+      std::construct_at(std::addressof(_static_data), other._static_data);
+    } else {
+      std::construct_at(std::addressof(_dynamic_data), other._dynamic_data);
+    }
+  }
+
+  // O(SMALL_SIZE / WORD_BITS) / O(1); nothrow / nothrow
+  constexpr socow_vector(socow_vector&& other) noexcept
+      : _size(other._size) {
+    if (other.small_object()) {
+      std::construct_at(std::addressof(_static_data), other._static_data);
+      other._static_data.fill(0);
+    } else {
+      std::construct_at(std::addressof(_dynamic_data), std::move(other._dynamic_data));
+      other._dynamic_data.~shared_data();
+      other.begin_static();
+    }
+    other._size = 0;
+  }
+
+  // O(SMALL_SIZE / WORD_BITS) / O(1); nothrow / nothrow
+  constexpr socow_vector& operator=(const socow_vector& other) noexcept {
+    if (this != &other) {
+      socow_vector copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  // O(SMALL_SIZE / WORD_BITS) / O(1); nothrow / nothrow
+  constexpr socow_vector& operator=(socow_vector&& other) noexcept {
+    if (this != &other) {
+      swap(other);
+    }
+    return *this;
+  }
+
+  constexpr ~socow_vector() {
+    if (!small_object()) {
+      _dynamic_data.~shared_data();
+    }
+  }
+
+  // Fields access
+
+  // O(1) / O(1); nothrow / nothrow
+  constexpr std::size_t size() const noexcept {
+    return small_object() ? _size : _dynamic_data->size;
+  }
+
+  // O(1) / O(1); nothrow / nothrow
+  constexpr bool empty() const noexcept {
+    return size() == 0;
+  }
+
+  // O(1) / O(1); nothrow / nothrow
+  constexpr std::size_t capacity() const noexcept {
+    return small_object() ? SMALL_SIZE : _dynamic_data->words.capacity() * WORD_BITS;
+  }
+
+  // O(1) / O(1); nothrow / nothrow
+  // The words holding the bits, the unused high bits of the last one are zero
+  constexpr std::span<const word> words() const noexcept {
+    return {word_data(), word_count(size())};
+  }
+
+  // Operations
+
+  // O(1) / O(1)*; nothrow / strong
+  constexpr void push_back(bool value) {
+    if (small_object() && !full()) [[likely]] {
+      _static_data[_size / WORD_BITS] |= word(value) << (_size % WORD_BITS);
+      ++_size;
+      return;
+    }
+    if (full()) [[unlikely]] {
+      change_storage(2 * SMALL_SIZE + 1);
+    }
+    unpin();
+    socow_bit_buffer<Storage>& buffer = *_dynamic_data;
+    if (buffer.size % WORD_BITS == 0) {
+      buffer.words.push_back(0);
+    }
+    buffer.words.back() |= word(value) << (buffer.size % WORD_BITS);
+    ++buffer.size;
+  }
+
+  // O(1) / O(1); nothrow / strong
+  constexpr void pop_back() {
+    if (small_object()) {
+      --_size;
+      _static_data[_size / WORD_BITS] &= ~(word(1) << (_size % WORD_BITS));
+    } else {
+      unpin();
+      socow_bit_buffer<Storage>& buffer = *_dynamic_data;
+      --buffer.size;
+      if (buffer.size % WORD_BITS == 0) {
+        buffer.words.pop_back();
+      } else {
+        buffer.words.back() &= ~(word(1) << (buffer.size % WORD_BITS));
+      }
+    }
+  }
+
+  // O(N / WORD_BITS) / O(N / WORD_BITS)*; strong / strong
+  // The bits from `pos` on move up a whole word at a time
+  constexpr iterator insert(const_iterator pos, bool value) {
+    std::size_t idx = pos._index;
+    push_back(false);
+    word* w = mutable_words();
+    std::size_t first = idx / WORD_BITS;
+    for (std::size_t i = word_count(size()) - 1; i != first; --i) {
+      w[i] = (w[i] << 1) | (w[i - 1] >> (WORD_BITS - 1));
+    }
+    word low = (word(1) << (idx % WORD_BITS)) - 1;
+    w[first] = (w[first] & low) | ((w[first] & ~low) << 1);
+    reference(w + first, idx % WORD_BITS) = value;
+    return iterator(w, idx);
+  }
+
+  // O(N / WORD_BITS) / O(N / WORD_BITS); nothrow / strong
+  constexpr iterator erase(const_iterator pos) {
+    return erase(pos, pos + 1);
+  }
+
+  // O(N / WORD_BITS) / O(N / WORD_BITS); nothrow / strong
+  // The bits past `last` move down a whole word at a time once the destination reaches a word boundary
+  constexpr iterator erase(const_iterator first, const_iterator last) {
+    std::size_t from = first._index;
+    std::size_t count = last._index - from;
+    if (count == 0) {
+      return begin() + from;
+    }
+    std::size_t old_size = size();
+    std::size_t new_size = old_size - count;
+    word* w = mutable_words();
+    std::size_t n = word_count(old_size);
+    std::size_t to = from;
+    for (; to != new_size && to % WORD_BITS != 0; ++to) {
+      reference(w + to / WORD_BITS, to % WORD_BITS) = test(w, to + count);
+    }
+    // Sources lie ahead of the destination, so every word is read before it is overwritten
+    for (; to < new_size; to += WORD_BITS) {
+      w[to / WORD_BITS] = extract(w, n, to + count);
+    }
+    truncate(new_size);
+    return begin() + from;
+  }
+
+  // O(N / WORD_BITS) / O(N / WORD_BITS)*; strong / strong
+  // New bits are set to `value`
+  constexpr void resize(std::size_t new_size, bool value = false) {
+    std::size_t old_size = size();
+    if (new_size <= old_size) {
+      if (new_size != old_size) {
+        truncate(new_size);
+      }
+      return;
+    }
+    reserve(new_size);
+    word* w;
+    if (small_object()) {
+      w = _static_data.data();
+      _size = new_size;
+    } else {
+      socow_bit_buffer<Storage>& buffer = *_dynamic_data;
+      while (buffer.words.size() != word_count(new_size)) {
+        buffer.words.push_back(0);
+      }
+      buffer.size = new_size;
+      w = buffer.words.data();
+    }
+    if (value) {
+      set_range(w, old_size, new_size);
+    }
+  }
+
+  // O(SMALL_SIZE / WORD_BITS) / O(N / WORD_BITS); strong / strong
+  constexpr void reserve(std::size_t new_capacity) {
+    if (small_object()) {
+      if (new_capacity > SMALL_SIZE) {
+        change_storage(new_capacity);
+      }
+    } else {
+      unpin(new_capacity);
+      _dynamic_data->words.reserve(word_count(new_capacity));
+    }
+  }
+
+  // O(1) / O(N / WORD_BITS); nothrow / strong
+  constexpr void shrink_to_fit() {
+    if (!small_object()) {
+      unpin();
+      _dynamic_data->words.shrink_to_fit();
+    }
+  }
+
+  // O(SMALL_SIZE / WORD_BITS) / O(1); nothrow / nothrow
+  constexpr void clear() noexcept {
+    if (small_object()) {
+      _static_data.fill(0);
+      _size = 0;
+    } else if (_dynamic_data.use_count() > 1) {
+      _dynamic_data.~shared_data();
+      begin_static();
+      _size = 0;
+    } else {
+      _dynamic_data->words.clear();
+      _dynamic_data->size = 0;
+    }
+  }
+
+  friend constexpr void swap(socow_vector& lhs, socow_vector& rhs) noexcept {
+    lhs.swap(rhs);
+  }
+
+  // O(SMALL_SIZE / WORD_BITS) nothrow
+  constexpr void swap(socow_vector& other) noexcept {
+    using std::swap;
+    if (small_object() && other.small_object()) {
+      swap(_static_data, other._static_data);
+    } else if (!small_object() && !other.small_object()) {
+      swap(_dynamic_data, other._dynamic_data);
+    } else {
+      socow_vector& on_heap = small_object() ? other : *this;
+      socow_vector& inline_ = small_object() ? *this : other;
+      shared_data<socow_bit_buffer<Storage>> buffer = std::move(on_heap._dynamic_data);
+      on_heap._dynamic_data.~shared_data();
+      std::construct_at(std::addressof(on_heap._static_data), inline_._static_data);
+      std::construct_at(std::addressof(inline_._dynamic_data), std::move(buffer));
+    }
+    swap(_size, other._size);
+  }
+
+  // Bit operations
+
+  // O(N / WORD_BITS) nothrow
+  // Number of set bits
+  constexpr std::size_t count() const noexcept {
+    std::size_t result = 0;
+    for (word w : words()) {
+      result += static_cast<std::size_t>(std::popcount(w));
+    }
+    return result;
+  }
+
+  // O(N / WORD_BITS) nothrow
+  // Index of the first set bit at or after `from`, size() if there is none
+  constexpr std::size_t find_first(std::size_t from = 0) const noexcept {
+    std::span<const word> w = words();
+    std::size_t i = from / WORD_BITS;
+    if (i >= w.size()) {
+      return size();
+    }
+    word current = w[i] & (~word(0) << (from % WORD_BITS));
+    while (current == 0) {
+      if (++i == w.size()) {
+        return size();
+      }
+      current = w[i];
+    }
+    return i * WORD_BITS + static_cast<std::size_t>(std::countr_zero(current));
+  }
+
+  // O(N / WORD_BITS) / O(N / WORD_BITS); nothrow / strong
+  // Inverts every bit
+  constexpr void flip() {
+    word* w = mutable_words();
+    std::size_t n = word_count(size());
+    for (std::size_t i = 0; i != n; ++i) {
+      w[i] = ~w[i];
+    }
+    if (size() % WORD_BITS != 0) {
+      w[n - 1] &= last_word_mask(size());
+    }
+  }
+
+  // O(N / WORD_BITS) / O(N / WORD_BITS); nothrow / strong
+  // Both vectors must have the same size
+  constexpr socow_vector& operator&=(const socow_vector& other) {
+    return combine(other, std::bit_and<word>());
+  }
+
+  // O(N / WORD_BITS) / O(N / WORD_BITS); nothrow / strong
+  constexpr socow_vector& operator|=(const socow_vector& other) {
+    return combine(other, std::bit_or<word>());
+  }
+
+  // O(N / WORD_BITS) / O(N / WORD_BITS); nothrow / strong
+  constexpr socow_vector& operator^=(const socow_vector& other) {
+    return combine(other, std::bit_xor<word>());
+  }
+
+  friend constexpr socow_vector operator&(socow_vector lhs, const socow_vector& rhs) {
+    lhs &= rhs;
+    return lhs;
+  }
+
+  friend constexpr socow_vector operator|(socow_vector lhs, const socow_vector& rhs) {
+    lhs |= rhs;
+    return lhs;
+  }
+
+  friend constexpr socow_vector operator^(socow_vector lhs, const socow_vector& rhs) {
+    lhs ^= rhs;
+    return lhs;
+  }
+
+  // O(N / WORD_BITS) nothrow
+  // Vectors sharing a buffer are equal without comparing the words
+  friend constexpr bool operator==(const socow_vector& lhs, const socow_vector& rhs) noexcept {
+    if (lhs.size() != rhs.size()) {
+      return false;
+    }
+    std::span<const word> l = lhs.words();
+    std::span<const word> r = rhs.words();
+    return l.data() == r.data() || std::equal(l.begin(), l.end(), r.begin());
+  }
+
+  // Element access
+
+  // O(1) / O(size); nothrow / strong
+  constexpr reference operator[](std::size_t index) {
+    assert(index < size());
+    return reference(mutable_words() + index / WORD_BITS, index % WORD_BITS);
+  }
+
+  // O(1) / O(1); nothrow / nothrow
+  constexpr bool operator[](std::size_t index) const noexcept {
+    assert(index < size());
+    return test(word_data(), index);
+  }
+
+  // O(1) / O(size); nothrow / strong
+  constexpr reference front() {
+    return operator[](0);
+  }
+
+  // O(1) / O(1); nothrow / nothrow
+  constexpr bool front() const noexcept {
+    return operator[](0);
+  }
+
+  // O(1) / O(size); nothrow / strong
+  constexpr reference back() {
+    return operator[](size() - 1);
+  }
+
+  // O(1) / O(1); nothrow / nothrow
+  constexpr bool back() const noexcept {
+    return operator[](size() - 1);
+  }
+
+  // Iterator
+
+  // O(1) / O(size); nothrow / strong
+  constexpr iterator begin() {
+    return iterator(mutable_words(), 0);
+  }
+
+  // O(1) / O(1); nothrow / nothrow
+  constexpr const_iterator begin() const noexcept {
+    return const_iterator(word_data(), 0);
+  }
+
+  // O(1) / O(size); nothrow / strong
+  constexpr iterator end() {
+    return iterator(mutable_words(), size());
+  }
+
+  // O(1) / O(1); nothrow / nothrow
+  constexpr const_iterator end() const noexcept {
+    return const_iterator(word_data(), size());
+  }
+
+  // Memory accounting
+
+  // O(1) / O(1); nothrow / nothrow
+  // Same accounting as any other socow_vector: the heap bytes are the words with the control block that owns them
+  constexpr socow_memory_usage memory_usage() const noexcept {
+    socow_memory_usage result;
+    result.inline_bytes = sizeof(socow_vector);
+    if (!small_object()) {
+      result.heap_bytes = _dynamic_data->words.capacity() * sizeof(word) +
+                          shared_data<socow_bit_buffer<Storage>>::control_block_size();
+      result.shared_bytes = static_cast<double>(result.heap_bytes) / static_cast<double>(_dynamic_data.use_count());
+    }
+    return result;
+  }
+
+  // Buffer handoff
+
+  // O(SMALL_SIZE / WORD_BITS) / O(1) if the buffer isn't shared, O(N / WORD_BITS) otherwise; strong / strong
+  // Moves the bits out as words and leaves this vector empty.
+  // A heap buffer no other vector shares is handed over as is.
+  constexpr socow_bit_buffer<Storage> release() {
+    socow_bit_buffer<Storage> result;
+    if (small_object()) {
+      if (_size != 0) {
+        result.words = vector<word, Storage>(std::as_const(_static_data), word_count(_size));
+        result.size = _size;
+        clear();
+      }
+      return result;
+    }
+    if (_dynamic_data.use_count() > 1) {
+      result = std::as_const(*_dynamic_data);
+    } else {
+      result = std::move(*_dynamic_data);
+    }
+    // The owner writes in place, and a cloning storage must not hand out its pages to later copies as clean
+    result.words.prepare_write();
+    _dynamic_data.~shared_data();
+    begin_static();
+    _size = 0;
+    return result;
+  }
+
+  // O(SMALL_SIZE / WORD_BITS) / O(1); strong / strong
+  // Takes over the words of `buffer`, which must hold exactly word_count(size) of them with the bits past `size` clear,
+  // as release() leaves them. Up to SMALL_SIZE bits are copied inline instead.
+  static constexpr socow_vector adopt(socow_bit_buffer<Storage>&& buffer) {
+    assert(buffer.words.size() == word_count(buffer.size));
+    assert(buffer.size % WORD_BITS == 0 || (buffer.words.back() & ~last_word_mask(buffer.size)) == 0);
+    socow_vector result;
+    if (buffer.size <= SMALL_SIZE) {
+      // Without inline words only an empty buffer gets here
+      if constexpr (SMALL_SIZE != 0) {
+        std::copy(std::as_const(buffer.words).begin(), std::as_const(buffer.words).end(), result._static_data.begin());
+      }
+      result._size = buffer.size;
+      buffer.words.clear();
+      buffer.size = 0;
+    } else {
+      shared_data<socow_bit_buffer<Storage>> data(std::move(buffer));
+      std::construct_at(std::addressof(result._dynamic_data), std::move(data));
+      result._size = SMALL_SIZE + 1;
+    }
+    return result;
+  }
+
+public:
+  std::size_t _size;
+
+  union {
+    shared_data<socow_bit_buffer<Storage>> _dynamic_data;
+    std::array<word, (SMALL_SIZE + WORD_BITS - 1) / WORD_BITS> _static_data;
+  };
+
+  constexpr bool small_object() const noexcept {
+    return _size <= SMALL_SIZE;
+  }
+
+  constexpr bool full() const noexcept {
+    return _size == SMALL_SIZE;
+  }
+
+  static constexpr std::size_t word_count(std::size_t bits) noexcept {
+    return (bits + WORD_BITS - 1) / WORD_BITS;
+  }
+
+  // Bits of the last word that are in use, for a size that doesn't fill it
+  static constexpr word last_word_mask(std::size_t bits) noexcept {
+    return ~word(0) >> (WORD_BITS - bits % WORD_BITS);
+  }
+
+  static constexpr bool test(const word* w, std::size_t index) noexcept {
+    return (w[index / WORD_BITS] >> (index % WORD_BITS)) & 1;
+  }
+
+  // WORD_BITS bits starting at `index` of the `n` words at `w`, zero past their end
+  static constexpr word extract(const word* w, std::size_t n, std::size_t index) noexcept {
+    std::size_t i = index / WORD_BITS;
+    std::size_t shift = index % WORD_BITS;
+    word result = i < n ? w[i] >> shift : 0;
+    if (shift != 0 && i + 1 < n) {
+      result |= w[i + 1] << (WORD_BITS - shift);
+    }
+    return result;
+  }
+
+  // Sets the bits [first, last), filling the whole words in between at once
+  static constexpr void set_range(word* w, std::size_t first, std::size_t last) noexcept {
+    for (; first != last && first % WORD_BITS != 0; ++first) {
+      w[first / WORD_BITS] |= word(1) << (first % WORD_BITS);
+    }
+    for (; last - first >= WORD_BITS; first += WORD_BITS) {
+      w[first / WORD_BITS] = ~word(0);
+    }
+    if (first != last) {
+      w[first / WORD_BITS] |= last_word_mask(last);
+    }
+  }
+
+  // Inline words are zeroed, which both keeps the unused bits clear and starts the union member
+  // during constant evaluation
+  constexpr void begin_static() noexcept {
+    std::construct_at(std::addressof(_static_data));
+  }
+
+  constexpr const word* word_data() const noexcept {
+    return small_object() ? _static_data.data() : std::as_const(_dynamic_data->words).data();
+  }
+
+  // O(1) / O(size); nothrow / strong
+  constexpr word* mutable_words() {
+    if (small_object()) {
+      return _static_data.data();
+    }
+    unpin();
+    return _dynamic_data->words.data();
+  }
+
+  // O(N / WORD_BITS) / O(N / WORD_BITS); strong / strong
+  // Drops the bits past `new_size`, clearing the ones that stay in the last word
+  constexpr void truncate(std::size_t new_size) {
+    std::size_t words_left = word_count(new_size);
+    word* w;
+    if (small_object()) {
+      w = _static_data.data();
+      std::fill(_static_data.begin() + words_left, _static_data.end(), 0);
+      _size = new_size;
+    } else {
+      unpin();
+      socow_bit_buffer<Storage>& buffer = *_dynamic_data;
+      buffer.words.erase(buffer.words.begin() + words_left, buffer.words.end());
+      buffer.size = new_size;
+      w = buffer.words.data();
+    }
+    if (new_size % WORD_BITS != 0) {
+      w[words_left - 1] &= last_word_mask(new_size);
+    }
+  }
+
+  template <typename Op>
+  constexpr socow_vector& combine(const socow_vector& other, Op op) {
+    assert(size() == other.size());
+    word* w = mutable_words();
+    // Read after unsharing: `other` may have shared the buffer this vector just copied
+    const word* source = other.word_data();
+    std::size_t n = word_count(size());
+    for (std::size_t i = 0; i != n; ++i) {
+      w[i] = op(w[i], source[i]);
+    }
+    return *this;
+  }
+
+  // O(SMALL_SIZE / WORD_BITS); strong
+  SOCOW_COLD constexpr void change_storage(std::size_t new_capacity) {
+    shared_data<socow_bit_buffer<Storage>> buffer(socow_bit_buffer<Storage>{});
+    buffer->words.reserve(word_count(new_capacity));
+    for (std::size_t i = 0; i != word_count(_size); ++i) {
+      buffer->words.push_back(_static_data[i]);
+    }
+    buffer->size = _size;
+    std::construct_at(std::addressof(_dynamic_data), std::move(buffer));
+    _size = SMALL_SIZE + 1;
+  }
+
+  // O(1) / O(N / WORD_BITS); nothrow / strong
+  constexpr void unpin(std::size_t min_capacity = 0) {
+    if (small_object()) {
+      return;
+    }
+    if (_dynamic_data.use_count() > 1) [[unlikely]] {
+      unshare(min_capacity);
+    }
+  }
+
+  // O(N / WORD_BITS); strong
+  SOCOW_COLD constexpr void unshare(std::size_t min_capacity) {
+    const socow_bit_buffer<Storage>& shared = *_dynamic_data;
+    std::size_t words = shared.words.size();
+    _dynamic_data = shared_data<socow_bit_buffer<Storage>>(socow_bit_buffer<Storage>{
+        shared.size,
+        vector<word, Storage>(shared.words, words, std::max(words, word_count(min_capacity))),
+    });
+  }
+};
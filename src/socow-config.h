@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+// Marks out-of-line slow paths (spilling to the heap, unsharing, reallocation),
+// keeping them out of the instruction stream of the inlined fast paths
+#if defined(__GNUC__) || defined(__clang__)
+#define SOCOW_COLD [[gnu::cold, gnu::noinline]]
+#elif defined(_MSC_VER)
+#define SOCOW_COLD __declspec(noinline)
+#else
+#define SOCOW_COLD
+#endif
+
+// Lets empty members (stateless storages and comparators, the profiler state of unprofiled builds)
+// take no space. MSVC accepts the standard attribute but ignores it.
+#ifdef _MSC_VER
+#define SOCOW_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#else
+#define SOCOW_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
+
+// Exception-free mode, implied by -fno-exceptions or requested explicitly by defining SOCOW_NO_EXCEPTIONS.
+// Errors go to the failure handler instead of being thrown, rollback code is compiled out
+// and buffers are relocated by moving the elements even if their move constructor may throw.
+#if !defined(SOCOW_NO_EXCEPTIONS) && !defined(__cpp_exceptions)
+#define SOCOW_NO_EXCEPTIONS
+#endif
+
+#ifdef SOCOW_NO_EXCEPTIONS
+inline constexpr bool SOCOW_EXCEPTIONS = false;
+#define SOCOW_TRY if (true)
+#define SOCOW_CATCH_ALL else
+#define SOCOW_RETHROW
+#else
+inline constexpr bool SOCOW_EXCEPTIONS = true;
+#define SOCOW_TRY try
+#define SOCOW_CATCH_ALL catch (...)
+#define SOCOW_RETHROW throw
+#endif
+
+// Called with the message of the error in exception-free mode. It must not return:
+// if it does, or no handler is set, the message is printed to stderr and the program aborts.
+using socow_failure_handler = void (*)(const char* what);
+
+inline std::atomic<socow_failure_handler>& socow_failure_handler_slot() noexcept {
+  static std::atomic<socow_failure_handler> handler{nullptr};
+  return handler;
+}
+
+// Returns the previous handler
+inline socow_failure_handler set_socow_failure_handler(socow_failure_handler handler) noexcept {
+  return socow_failure_handler_slot().exchange(handler);
+}
+
+// Throws `error`, or reports it to the failure handler in exception-free mode
+template <typename Exception>
+[[noreturn]] SOCOW_COLD void socow_throw(const Exception& error) {
+#ifdef SOCOW_NO_EXCEPTIONS
+  if (socow_failure_handler handler = socow_failure_handler_slot().load()) {
+    handler(error.what());
+  }
+  std::fprintf(stderr, "socow_vector: %s\n", error.what());
+  std::abort();
+#else
+  throw error;
+#endif
+}
+
+// Size-distribution profiling is enabled by defining SOCOW_PROFILE for the whole program, see socow-profiler.h,
+// which socow-vector.h includes only then. Otherwise source locations are empty and the per-vector state does nothing.
+#ifndef SOCOW_PROFILE
+struct socow_source_location {
+  static constexpr socow_source_location current() noexcept {
+    return {};
+  }
+};
+
+class socow_profile_state {
+public:
+  template <typename Vector>
+  constexpr void attach(std::size_t, std::size_t, const socow_source_location&) noexcept {}
+
+  constexpr socow_source_location location() const noexcept {
+    return {};
+  }
+
+  constexpr void note_size(std::size_t) noexcept {}
+
+  constexpr void move_from(socow_profile_state&, std::size_t) noexcept {}
+
+  constexpr void record_spill() noexcept {}
+
+  constexpr void record_unpin(std::size_t) noexcept {}
+
+  constexpr void record_destruction(std::size_t) noexcept {}
+};
+#endif
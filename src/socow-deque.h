@@ -0,0 +1,421 @@
+#pragma once
+
+#include "ring-buffer.h"
+#include "shared-data.h"
+#include "socow-config.h"
+#include "socow-vector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+// Double-ended queue with the small-object and copy-on-write optimizations of socow_vector.
+// Both buffers are circular: up to SMALL_SIZE elements live in an inline ring, larger deques in a heap ring
+// shared between copies. Pushing and popping at either end takes O(1), and `insert` and `erase`
+// move only the elements on the shorter side of the position.
+// By default SMALL_SIZE leaves room for the index of the first element within one cache line.
+template <typename T, std::size_t SMALL_SIZE = socow_small_size<T, SOCOW_CACHE_LINE_SIZE - sizeof(std::size_t)>()>
+class socow_deque {
+public:
+  using value_type = T;
+
+  using reference = T&;
+  using const_reference = const T&;
+
+  using iterator = ring_iterator<T>;
+  using const_iterator = ring_iterator<const T>;
+
+public:
+  // O(1) nothrow
+  socow_deque() noexcept
+      : _size(0)
+      , _head(0) {}
+
+  // O(SMALL_SIZE) / O(1); strong / nothrow
+  socow_deque(const socow_deque& other)
+    requires std::copy_constructible<T>
+      : _size(0)
+      , _head(0) {
+    if (other.small_object()) {
+      SOCOW_TRY {
+        for (const T& value : other) {
+          ring<T>::emplace_back(_static_data.data(), SMALL_SIZE, _head, _size, value);
+        }
+      }
+      SOCOW_CATCH_ALL {
+        ring<T>::destroy(_static_data.data(), SMALL_SIZE, _head, _size);
+        SOCOW_RETHROW;
+      }
+    } else {
+      std::construct_at(&_dynamic_data, other._dynamic_data);
+      _size = other._size;
+    }
+  }
+
+  // O(SMALL_SIZE) / O(1); nothrow / nothrow
+  socow_deque(socow_deque&& other) noexcept
+      : _size(0)
+      , _head(0) {
+    take(other);
+  }
+
+  // O(SMALL_SIZE) / O(1); strong / nothrow
+  socow_deque& operator=(const socow_deque& other)
+    requires std::copy_constructible<T>
+  {
+    if (this != &other) {
+      socow_deque copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  // O(SMALL_SIZE) / O(1); nothrow / nothrow
+  socow_deque& operator=(socow_deque&& other) noexcept {
+    if (this != &other) {
+      swap(other);
+    }
+    return *this;
+  }
+
+  // O(SMALL_SIZE) / O(1); nothrow / nothrow
+  ~socow_deque() {
+    if (small_object()) {
+      ring<T>::destroy(_static_data.data(), SMALL_SIZE, _head, _size);
+    } else {
+      _dynamic_data.~shared_data();
+    }
+  }
+
+  // Fields access
+
+  // O(1) / O(1); nothrow / nothrow
+  std::size_t size() const noexcept {
+    return small_object() ? _size : _dynamic_data->size();
+  }
+
+  // O(1) / O(1); nothrow / nothrow
+  bool empty() const noexcept {
+    return size() == 0;
+  }
+
+  // O(1) / O(1); nothrow / nothrow
+  std::size_t capacity() const noexcept {
+    return small_object() ? SMALL_SIZE : _dynamic_data->capacity();
+  }
+
+  // Element access
+
+  // O(1) / O(1); nothrow / nothrow
+  const T& operator[](std::size_t index) const noexcept {
+    assert(index < size());
+    if (small_object()) {
+      return _static_data[ring<T>::slot(SMALL_SIZE, _head, index)];
+    } else {
+      return std::as_const(*_dynamic_data)[index];
+    }
+  }
+
+  // O(1) / O(size); nothrow / strong
+  T& operator[](std::size_t index) {
+    assert(index < size());
+    if (small_object()) {
+      return _static_data[ring<T>::slot(SMALL_SIZE, _head, index)];
+    } else {
+      unpin();
+      return (*_dynamic_data)[index];
+    }
+  }
+
+  // O(1) / O(1); nothrow / nothrow
+  const T& front() const noexcept {
+    return (*this)[0];
+  }
+
+  // O(1) / O(size); nothrow / strong
+  T& front() {
+    return (*this)[0];
+  }
+
+  // O(1) / O(1); nothrow / nothrow
+  const T& back() const noexcept {
+    return (*this)[size() - 1];
+  }
+
+  // O(1) / O(size); nothrow / strong
+  T& back() {
+    return (*this)[size() - 1];
+  }
+
+  // Iterators
+
+  // O(1) / O(1); nothrow / nothrow
+  const_iterator begin() const noexcept {
+    if (small_object()) {
+      return {_static_data.data(), SMALL_SIZE, _head};
+    } else {
+      return std::as_const(*_dynamic_data).begin();
+    }
+  }
+
+  // O(1) / O(1); nothrow / nothrow
+  const_iterator end() const noexcept {
+    return begin() + static_cast<std::ptrdiff_t>(size());
+  }
+
+  // O(1) / O(size); nothrow / strong
+  iterator begin() {
+    if (small_object()) {
+      return {_static_data.data(), SMALL_SIZE, _head};
+    } else {
+      unpin();
+      return _dynamic_data->begin();
+    }
+  }
+
+  // O(1) / O(size); nothrow / strong
+  iterator end() {
+    return begin() + static_cast<std::ptrdiff_t>(size());
+  }
+
+  // Operations
+
+  // O(1) / O(1)*; strong / strong
+  void push_back(const T& value)
+    requires std::copy_constructible<T>
+  {
+    T copy = value;
+    push_back(std::move(copy));
+  }
+
+  // O(1) / O(1)*; nothrow / strong
+  void push_back(T&& value) {
+    if (small_object() && !full()) [[likely]] {
+      ring<T>::emplace_back(_static_data.data(), SMALL_SIZE, _head, _size, std::move(value));
+    } else {
+      prepare_grow();
+      _dynamic_data->push_back(std::move(value));
+    }
+  }
+
+  // O(1) / O(1)*; strong / strong
+  void push_front(const T& value)
+    requires std::copy_constructible<T>
+  {
+    T copy = value;
+    push_front(std::move(copy));
+  }
+
+  // O(1) / O(1)*; nothrow / strong
+  void push_front(T&& value) {
+    if (small_object() && !full()) [[likely]] {
+      ring<T>::emplace_front(_static_data.data(), SMALL_SIZE, _head, _size, std::move(value));
+    } else {
+      prepare_grow();
+      _dynamic_data->push_front(std::move(value));
+    }
+  }
+
+  // O(1) / O(1); nothrow / strong
+  void pop_back() {
+    if (small_object()) {
+      ring<T>::pop_back(_static_data.data(), SMALL_SIZE, _head, _size);
+    } else {
+      unpin();
+      _dynamic_data->pop_back();
+    }
+  }
+
+  // O(1) / O(1); nothrow / strong
+  void pop_front() {
+    if (small_object()) {
+      ring<T>::pop_front(_static_data.data(), SMALL_SIZE, _head, _size);
+    } else {
+      unpin();
+      _dynamic_data->pop_front();
+    }
+  }
+
+  // O(SMALL_SIZE) / O(min(index, size - index))*; strong / strong
+  iterator insert(const_iterator pos, const T& value)
+    requires std::copy_constructible<T>
+  {
+    T copy = value;
+    return insert(pos, std::move(copy));
+  }
+
+  // O(SMALL_SIZE) / O(min(index, size - index))*; strong / strong
+  // Moves the elements on the shorter side of `pos`
+  iterator insert(const_iterator pos, T&& value) {
+    std::size_t index = pos - std::as_const(*this).begin();
+    if (small_object() && !full()) [[likely]] {
+      ring<T>::insert(_static_data.data(), SMALL_SIZE, _head, _size, index, std::move(value));
+    } else {
+      prepare_grow();
+      _dynamic_data->insert(index, std::move(value));
+    }
+    return begin() + static_cast<std::ptrdiff_t>(index);
+  }
+
+  // O(SMALL_SIZE) / O(min(index, size - index)); nothrow / strong
+  iterator erase(const_iterator pos) {
+    return erase(pos, std::next(pos));
+  }
+
+  // O(SMALL_SIZE) / O(min(first, size - last) + last - first); nothrow / strong
+  // Moves the elements on the shorter side of the erased range
+  iterator erase(const_iterator first, const_iterator last) {
+    const_iterator start = std::as_const(*this).begin();
+    std::size_t from = first - start;
+    std::size_t to = last - start;
+    if (small_object()) {
+      ring<T>::erase(_static_data.data(), SMALL_SIZE, _head, _size, from, to);
+    } else if (from != to) {
+      unpin();
+      _dynamic_data->erase(from, to);
+    }
+    return begin() + static_cast<std::ptrdiff_t>(from);
+  }
+
+  // O(SMALL_SIZE) / O(size); strong / strong
+  void reserve(std::size_t new_capacity) {
+    if (small_object()) {
+      if (new_capacity > SMALL_SIZE) {
+        change_storage(new_capacity);
+      }
+    } else {
+      unpin(new_capacity);
+      _dynamic_data->reserve(new_capacity);
+    }
+  }
+
+  // O(SMALL_SIZE) / O(N); nothrow / nothrow
+  void clear() noexcept {
+    if (small_object()) {
+      ring<T>::destroy(_static_data.data(), SMALL_SIZE, _head, _size);
+      _size = 0;
+      _head = 0;
+    } else if (_dynamic_data.use_count() > 1) {
+      // Let the other owners keep the shared buffer
+      _dynamic_data.~shared_data();
+      _size = 0;
+      _head = 0;
+    } else {
+      _dynamic_data->clear();
+    }
+  }
+
+  // O(SMALL_SIZE) / O(1); nothrow / nothrow
+  void swap(socow_deque& other) noexcept {
+    if (this == &other) {
+      return;
+    }
+    socow_deque tmp(std::move(other));
+    other.take(*this);
+    take(tmp);
+  }
+
+  friend void swap(socow_deque& lhs, socow_deque& rhs) noexcept {
+    lhs.swap(rhs);
+  }
+
+  // O(N) nothrow
+  friend bool operator==(const socow_deque& lhs, const socow_deque& rhs) {
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+  }
+
+  // Same as socow_vector::memory_usage without the visitor
+  socow_memory_usage memory_usage() const {
+    socow_memory_usage result;
+    result.inline_bytes = sizeof(socow_deque);
+    if (!small_object()) {
+      result.heap_bytes = capacity() * sizeof(T) + shared_data<ring_buffer<T>>::control_block_size();
+      result.shared_bytes = static_cast<double>(result.heap_bytes) / static_cast<double>(_dynamic_data.use_count());
+    }
+    return result;
+  }
+
+private:
+  // As in socow_vector, a size above SMALL_SIZE marks the heap buffer, which keeps the real size
+  std::size_t _size;
+  // Slot of the first inline element
+  std::size_t _head;
+
+  union {
+    shared_data<ring_buffer<T>> _dynamic_data;
+    std::array<T, SMALL_SIZE> _static_data;
+  };
+
+  bool small_object() const noexcept {
+    return _size <= SMALL_SIZE;
+  }
+
+  bool full() const noexcept {
+    return _size == SMALL_SIZE;
+  }
+
+  // O(SMALL_SIZE) / O(1); nothrow / nothrow
+  // Moves the elements of `from` into this deque, which must hold none, and leaves `from` empty.
+  // Inline elements are moved to the start of the inline ring.
+  void take(socow_deque& from) noexcept {
+    if (from.small_object()) {
+      for (std::size_t i = 0; i != from._size; ++i) {
+        T& value = from._static_data[ring<T>::slot(SMALL_SIZE, from._head, i)];
+        new (_static_data.data() + i) T(std::move(value));
+        value.~T();
+      }
+    } else {
+      std::construct_at(&_dynamic_data, std::move(from._dynamic_data));
+      from._dynamic_data.~shared_data();
+    }
+    _size = std::exchange(from._size, 0);
+    _head = 0;
+    from._head = 0;
+  }
+
+  // O(SMALL_SIZE) / O(size); strong / strong
+  // Makes sure the element about to be added goes to a uniquely owned heap buffer
+  void prepare_grow() {
+    if (full()) [[unlikely]] {
+      change_storage(2 * SMALL_SIZE + 1);
+    }
+    unpin(size() + 1);
+  }
+
+  // O(SMALL_SIZE); strong
+  SOCOW_COLD void change_storage(std::size_t new_capacity) {
+    iterator first(_static_data.data(), SMALL_SIZE, _head);
+    shared_data<ring_buffer<T>> buffer(std::make_move_iterator(first), _size, new_capacity);
+    ring<T>::destroy(_static_data.data(), SMALL_SIZE, _head, _size);
+    _size = SMALL_SIZE + 1;
+    _head = 0;
+    std::construct_at(&_dynamic_data, std::move(buffer));
+  }
+
+  // O(1) / O(size); nothrow / strong
+  // A caller about to grow the buffer passes the capacity it needs, so that a shared buffer is copied only once
+  void unpin(std::size_t min_capacity = 0) {
+    if (small_object()) {
+      return;
+    }
+    if constexpr (std::copy_constructible<T>) {
+      if (_dynamic_data.use_count() > 1) [[unlikely]] {
+        unshare(min_capacity);
+      }
+    } else {
+      assert(_dynamic_data.use_count() == 1);
+    }
+  }
+
+  // O(size); strong
+  SOCOW_COLD void unshare(std::size_t min_capacity)
+    requires std::copy_constructible<T>
+  {
+    const ring_buffer<T>& shared = *_dynamic_data;
+    _dynamic_data = shared_data<ring_buffer<T>>(shared.begin(), shared.size(), std::max(shared.size(), min_capacity));
+  }
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "socow-config.h"
+#include "socow-flat-set.h"
+#include "socow-vector.h"
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+// Map with unique keys kept as a sorted socow_vector of pairs: small maps are stored inline
+// and copies of large ones share a buffer. Values are changed through `operator[]`, `at` and `insert_or_assign`,
+// which unshare the buffer; iterators are read-only.
+template <typename K, typename V, std::size_t SMALL_SIZE = socow_small_size<std::pair<K, V>>(),
+          typename Compare = std::less<K>>
+class socow_flat_map : public socow_sorted_vector<std::pair<K, V>, socow_pair_first, SMALL_SIZE, Compare> {
+  using base = socow_sorted_vector<std::pair<K, V>, socow_pair_first, SMALL_SIZE, Compare>;
+
+public:
+  using mapped_type = V;
+
+public:
+  using base::base;
+
+  // O(N); strong
+  // Inserts a default-constructed value if there is no `key`
+  V& operator[](const K& key)
+    requires std::copy_constructible<K> && std::default_initializable<V>
+  {
+    auto it = this->lower_bound(key);
+    std::size_t index = it - this->begin();
+    if (it == this->end() || this->_less(key, it->first)) {
+      this->_data.insert(this->_data.begin() + index, std::pair<K, V>(key, V()));
+    }
+    return this->_data[index].second;
+  }
+
+  // O(log N) / O(N) if the buffer is shared; strong
+  V& at(const K& key) {
+    return this->_data[index_of(key)].second;
+  }
+
+  // O(log N); strong
+  const V& at(const K& key) const {
+    return this->begin()[index_of(key)].second;
+  }
+
+  // O(N); strong
+  // Returns true if the value was inserted, false if it was assigned
+  template <typename M>
+  bool insert_or_assign(K key, M&& value) {
+    auto it = this->lower_bound(key);
+    std::size_t index = it - this->begin();
+    if (it != this->end() && !this->_less(key, it->first)) {
+      this->_data[index].second = std::forward<M>(value);
+      return false;
+    }
+    this->_data.insert(this->_data.begin() + index, std::pair<K, V>(std::move(key), std::forward<M>(value)));
+    return true;
+  }
+
+private:
+  std::size_t index_of(const K& key) const {
+    auto it = this->find(key);
+    if (it == this->end()) {
+      socow_throw(std::out_of_range("socow_flat_map::at"));
+    }
+    return it - this->begin();
+  }
+};
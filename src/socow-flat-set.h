@@ -0,0 +1,379 @@
+#pragma once
+
+#include "socow-config.h"
+#include "socow-vector.h"
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Binary search without branches on the comparison: the trip count depends only on `count`
+// and the step is scaled by the comparison result (GCC turns a ternary here back into a jump),
+// so random keys cause no mispredictions.
+// Returns the first element whose key is not less than `key`.
+template <typename Value, typename Key, typename KeyOf, typename Compare>
+const Value* socow_lower_bound(const Value* first, std::size_t count, const Key& key, const KeyOf& key_of,
+                               const Compare& less) {
+  if (count == 0) {
+    return first;
+  }
+  while (count > 1) {
+    std::size_t half = count / 2;
+    first += static_cast<std::size_t>(less(key_of(first[half - 1]), key)) * half;
+    count -= half;
+  }
+  return first + less(key_of(*first), key);
+}
+
+// Key of a map entry
+struct socow_pair_first {
+  template <typename Pair>
+  const auto& operator()(const Pair& pair) const noexcept {
+    return pair.first;
+  }
+};
+
+// Sorted vector of values with unique keys: the common part of socow_flat_set and socow_flat_map.
+// Lookups never unshare the buffer. Values can't be changed through iterators, since that could break the order.
+template <typename Value, typename KeyOf, std::size_t SMALL_SIZE, typename Compare>
+class socow_sorted_vector {
+  static_assert(!std::is_same_v<Value, bool>, "socow_vector<bool> is bit-packed, there are no bool pointers");
+
+public:
+  using key_type = std::remove_cvref_t<std::invoke_result_t<KeyOf, const Value&>>;
+  using value_type = Value;
+  using key_compare = Compare;
+
+  using const_iterator = const Value*;
+  using iterator = const_iterator;
+
+public:
+  socow_sorted_vector() = default;
+
+  explicit socow_sorted_vector(Compare less)
+      : _less(std::move(less)) {}
+
+  // O(N log N)
+  socow_sorted_vector(std::initializer_list<Value> values, Compare less = Compare())
+    requires std::copy_constructible<Value>
+      : _less(std::move(less)) {
+    insert_range(values);
+  }
+
+  // Fields access
+
+  // O(1) nothrow
+  std::size_t size() const noexcept {
+    return _data.size();
+  }
+
+  // O(1) nothrow
+  bool empty() const noexcept {
+    return _data.empty();
+  }
+
+  // O(1) nothrow
+  std::size_t capacity() const noexcept {
+    return _data.capacity();
+  }
+
+  // O(1) nothrow
+  const_iterator begin() const noexcept {
+    return _data.begin();
+  }
+
+  // O(1) nothrow
+  const_iterator end() const noexcept {
+    return _data.end();
+  }
+
+  // O(1) nothrow
+  const Value& operator[](std::size_t index) const noexcept {
+    return _data[index];
+  }
+
+  key_compare key_comp() const {
+    return _less;
+  }
+
+  // Lookup
+
+  // O(log N) nothrow
+  const_iterator lower_bound(const key_type& key) const noexcept {
+    return socow_lower_bound(begin(), size(), key, _key_of, _less);
+  }
+
+  // O(log N) nothrow
+  const_iterator upper_bound(const key_type& key) const noexcept {
+    const_iterator it = lower_bound(key);
+    return it != end() && !_less(key, _key_of(*it)) ? it + 1 : it;
+  }
+
+  // O(log N) nothrow
+  const_iterator find(const key_type& key) const noexcept {
+    const_iterator it = lower_bound(key);
+    return it != end() && !_less(key, _key_of(*it)) ? it : end();
+  }
+
+  // O(log N) nothrow
+  bool contains(const key_type& key) const noexcept {
+    return find(key) != end();
+  }
+
+  // O(log N) nothrow
+  std::size_t count(const key_type& key) const noexcept {
+    return contains(key);
+  }
+
+  // Modifiers
+
+  // O(N); strong
+  // Does nothing if there already is a value with an equivalent key
+  std::pair<const_iterator, bool> insert(const Value& value)
+    requires std::copy_constructible<Value>
+  {
+    return insert_unique(value);
+  }
+
+  // O(N); strong
+  std::pair<const_iterator, bool> insert(Value&& value) {
+    return insert_unique(std::move(value));
+  }
+
+  // O(M log M + N + M); strong (basic for move-only values)
+  // Sorts the new values and merges them with the current ones into a single new buffer,
+  // so the current buffer is never unshared. Of several equivalent keys the one already present
+  // or else the first one in `range` is kept.
+  template <std::ranges::input_range R>
+  void insert_range(R&& range) {
+    std::vector<Value> incoming;
+    if constexpr (std::ranges::sized_range<R>) {
+      incoming.reserve(std::ranges::size(range));
+    }
+    for (auto&& value : range) {
+      // The elements of a container passed as an rvalue are moved
+      if constexpr (std::is_lvalue_reference_v<R> || std::ranges::view<std::remove_cvref_t<R>>) {
+        incoming.emplace_back(std::forward<decltype(value)>(value));
+      } else {
+        incoming.emplace_back(std::move(value));
+      }
+    }
+    auto less = [this](const Value& lhs, const Value& rhs) { return _less(_key_of(lhs), _key_of(rhs)); };
+    auto equivalent = [&less](const Value& lhs, const Value& rhs) { return !less(lhs, rhs) && !less(rhs, lhs); };
+    std::stable_sort(incoming.begin(), incoming.end(), less);
+    incoming.erase(std::unique(incoming.begin(), incoming.end(), equivalent), incoming.end());
+    if (incoming.empty()) {
+      return;
+    }
+
+    socow_vector<Value, SMALL_SIZE> merged;
+    merged.reserve(size() + incoming.size());
+    auto take_current = [this, &merged](std::size_t index) {
+      // A vector of move-only values is never shared, so moving out of it doesn't copy the buffer
+      if constexpr (std::copy_constructible<Value>) {
+        merged.push_back(std::as_const(_data)[index]);
+      } else {
+        merged.push_back(std::move(_data[index]));
+      }
+    };
+    std::size_t i = 0;
+    auto j = incoming.begin();
+    while (i != size() && j != incoming.end()) {
+      if (less(*j, (*this)[i])) {
+        merged.push_back(std::move(*j++));
+      } else {
+        if (!less((*this)[i], *j)) {
+          ++j;
+        }
+        take_current(i++);
+      }
+    }
+    for (; i != size(); ++i) {
+      take_current(i);
+    }
+    for (; j != incoming.end(); ++j) {
+      merged.push_back(std::move(*j));
+    }
+    _data.swap(merged);
+  }
+
+  // O(N); strong
+  const_iterator erase(const_iterator pos) {
+    std::size_t index = pos - begin();
+    _data.erase(_data.begin() + index);
+    return begin() + index;
+  }
+
+  // O(N); strong
+  std::size_t erase(const key_type& key) {
+    const_iterator it = find(key);
+    if (it == end()) {
+      return 0;
+    }
+    erase(it);
+    return 1;
+  }
+
+  // O(N); nothrow
+  void clear() noexcept {
+    _data.clear();
+  }
+
+  // O(N); strong
+  void reserve(std::size_t new_capacity) {
+    _data.reserve(new_capacity);
+  }
+
+  // O(1) nothrow
+  void swap(socow_sorted_vector& other) noexcept {
+    using std::swap;
+    _data.swap(other._data);
+    swap(_less, other._less);
+  }
+
+  friend void swap(socow_sorted_vector& lhs, socow_sorted_vector& rhs) noexcept {
+    lhs.swap(rhs);
+  }
+
+  // O(N) nothrow
+  friend bool operator==(const socow_sorted_vector& lhs, const socow_sorted_vector& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  }
+
+  // Same as socow_vector::memory_usage, with the inline bytes of the whole container
+  template <typename Visit = socow_element_usage>
+  socow_memory_usage memory_usage(Visit visit = {}) const {
+    socow_memory_usage result = _data.memory_usage(std::move(visit));
+    result.inline_bytes = sizeof(socow_sorted_vector);
+    return result;
+  }
+
+protected:
+  template <typename V>
+  std::pair<const_iterator, bool> insert_unique(V&& value) {
+    const_iterator it = lower_bound(_key_of(value));
+    if (it != end() && !_less(_key_of(value), _key_of(*it))) {
+      return {it, false};
+    }
+    std::size_t index = it - begin();
+    _data.insert(_data.begin() + index, std::forward<V>(value));
+    return {begin() + index, true};
+  }
+
+  socow_vector<Value, SMALL_SIZE> _data;
+  SOCOW_NO_UNIQUE_ADDRESS KeyOf _key_of;
+  SOCOW_NO_UNIQUE_ADDRESS Compare _less;
+};
+
+// Set of unique keys kept in a sorted socow_vector:
+// small sets are stored inline and copies of large ones share a buffer
+template <typename K, std::size_t SMALL_SIZE = socow_small_size<K>(), typename Compare = std::less<K>>
+class socow_flat_set : public socow_sorted_vector<K, std::identity, SMALL_SIZE, Compare> {
+  using base = socow_sorted_vector<K, std::identity, SMALL_SIZE, Compare>;
+
+public:
+  using base::base;
+};
+
+// Read-only copy of a set in Eytzinger (breadth-first) order. The top levels of the implicit search tree
+// share a few cache lines and the descent has no branches on the keys, which beats a binary search
+// once the set no longer fits in cache. Copies share one buffer.
+template <typename K, typename Compare = std::less<K>>
+class socow_eytzinger_set {
+  static_assert(!std::is_same_v<K, bool>, "socow_vector<bool> is bit-packed, there are no bool pointers");
+
+public:
+  using key_type = K;
+  using key_compare = Compare;
+
+public:
+  socow_eytzinger_set() = default;
+
+  // O(N)
+  template <std::size_t SMALL_SIZE>
+  explicit socow_eytzinger_set(const socow_flat_set<K, SMALL_SIZE, Compare>& set)
+      : _less(set.key_comp()) {
+    // Node k (1-based) has children 2k and 2k + 1: an in-order walk assigns the sorted ranks
+    std::vector<std::size_t> rank(set.size() + 1);
+    std::size_t next = 0;
+    auto walk = [&](auto& self, std::size_t node) -> void {
+      if (node <= set.size()) {
+        self(self, 2 * node);
+        rank[node] = next++;
+        self(self, 2 * node + 1);
+      }
+    };
+    walk(walk, 1);
+
+    _data.reserve(set.size());
+    for (std::size_t node = 1; node <= set.size(); ++node) {
+      _data.push_back(set[rank[node]]);
+    }
+  }
+
+  // O(1) nothrow
+  std::size_t size() const noexcept {
+    return _data.size();
+  }
+
+  // O(1) nothrow
+  bool empty() const noexcept {
+    return _data.empty();
+  }
+
+  // O(log N) nothrow
+  // Returns the smallest key not less than `key` or nullptr if there is none
+  const K* lower_bound(const K& key) const noexcept {
+    const K* nodes = _data.data();
+    std::size_t node = 1;
+    while (node <= size()) {
+      prefetch(nodes, PREFETCH_DISTANCE * node);
+      node = 2 * node + _less(nodes[node - 1], key);
+    }
+    // Going right past the answer only appends ones: drop them and the last turn to the left
+    node >>= std::countr_one(node) + 1;
+    return node == 0 ? nullptr : nodes + node - 1;
+  }
+
+  // O(log N) nothrow
+  bool contains(const K& key) const noexcept {
+    const K* it = lower_bound(key);
+    return it != nullptr && !_less(key, *it);
+  }
+
+  // Same as socow_vector::memory_usage, with the inline bytes of the whole set
+  template <typename Visit = socow_element_usage>
+  socow_memory_usage memory_usage(Visit visit = {}) const {
+    socow_memory_usage result = _data.memory_usage(std::move(visit));
+    result.inline_bytes = sizeof(socow_eytzinger_set);
+    return result;
+  }
+
+private:
+  // The descendants of a node `log2(PREFETCH_DISTANCE)` levels down lie next to each other:
+  // fetching them early overlaps the cache misses of consecutive levels
+  static constexpr std::size_t PREFETCH_DISTANCE = std::bit_floor(std::max<std::size_t>(
+      SOCOW_CACHE_LINE_SIZE / sizeof(K), 1));
+
+  // The node may be past the end: the address is only a hint, so it is computed without forming a pointer
+  static void prefetch(const K* nodes, std::size_t node) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(reinterpret_cast<const void*>(reinterpret_cast<std::uintptr_t>(nodes) + node * sizeof(K)));
+#else
+    (void)nodes;
+    (void)node;
+#endif
+  }
+
+  socow_vector<K, 0> _data;
+  SOCOW_NO_UNIQUE_ADDRESS Compare _less;
+};
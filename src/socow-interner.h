@@ -0,0 +1,142 @@
+#pragma once
+
+#include "heap-storage.h"
+#include "socow-vector.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+
+// Hash-consing table for socow_vector: `intern` returns a vector sharing the buffer of an identical one
+// interned before, so independently built copies of the same contents end up taking the memory of one.
+// Only heap buffers are interned, inline vectors are returned as they are.
+//
+// An entry that no vector outside the table references is dead. Dead entries are dropped by `purge()`,
+// which `intern` also runs once it has been called as many times as there were entries left by the last purge
+// (at least MIN_PURGE_SIZE times). Lookups count as well as insertions, so a table that stops growing is still purged,
+// and the passes stay amortized O(1) per call. A table that nobody interns into keeps its dead entries
+// until `purge()` is called.
+//
+// Liveness is read from use_count(), which adds up both counters of a biased count: a release queued for the owner
+// of the count already counts as done. Dropping an entry frees its buffer only once the owner has merged its queue,
+// though, if the buffer was created on another thread and is still owned by it (see biased_count).
+//
+// Interned vectors stay copy-on-write: writing to one unshares it from the table, as from any other copy.
+// The table itself is not thread-safe; the vectors it returns are as thread-safe as any other.
+template <typename T, std::size_t SMALL_SIZE = socow_small_size<T>(), typename Storage = heap_storage,
+          typename Hash = std::hash<T>>
+class socow_interner {
+  static_assert(!std::is_same_v<T, bool>, "socow_vector<bool> is bit-packed and has no buffer of elements");
+
+public:
+  using vector_type = socow_vector<T, SMALL_SIZE, Storage>;
+
+public:
+  socow_interner() = default;
+
+  socow_interner(const socow_interner&) = delete;
+  socow_interner& operator=(const socow_interner&) = delete;
+
+  // O(1) nothrow
+  // Number of entries, the dead ones not yet purged included
+  std::size_t size() const noexcept {
+    return _entries.size();
+  }
+
+  // O(N) on average, amortized over purges; strong
+  // Returns a vector with the contents of `value`, sharing the buffer of an equal entry if there is one
+  vector_type intern(vector_type value) {
+    if (!value.has_buffer()) {
+      return value;
+    }
+    entry probe{hash(value), std::move(value)};
+    auto it = _entries.find(probe);
+    vector_type result;
+    if (it != _entries.end()) {
+      result = it->value;
+    } else {
+      result = probe.value;
+      _entries.insert(std::move(probe));
+    }
+    if (++_calls >= std::max(_live, MIN_PURGE_SIZE)) {
+      purge();
+    }
+    return result;
+  }
+
+  // O(N) nothrow
+  // Drops the entries whose buffers are referenced only by the table. Returns the number of dropped entries.
+  std::size_t purge() noexcept {
+    std::size_t dropped =
+        std::erase_if(_entries, [](const entry& e) { return e.value._dynamic_data.use_count() == 1; });
+    _live = _entries.size();
+    _calls = 0;
+    return dropped;
+  }
+
+  // O(N) nothrow
+  void clear() noexcept {
+    _entries.clear();
+    _live = 0;
+    _calls = 0;
+  }
+
+  // O(1) / O(SMALL_SIZE)
+  // Equality of vectors returned by the same table: equal heap vectors share their buffer
+  static bool equal(const vector_type& lhs, const vector_type& rhs) {
+    if (lhs.size() != rhs.size()) {
+      return false;
+    }
+    if (!lhs.small_object() && !rhs.small_object()) {
+      return lhs.data() == rhs.data();
+    }
+    // One of them is inline, so there are at most SMALL_SIZE elements to compare
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin());
+  }
+
+  // O(N)
+  // Hash of the contents. Elements without padding hashed by std::hash are hashed as one block of bytes.
+  static std::size_t hash(const vector_type& value) {
+    if constexpr (std::is_same_v<Hash, std::hash<T>> && std::has_unique_object_representations_v<T>) {
+      return std::hash<std::string_view>()(
+          std::string_view(reinterpret_cast<const char*>(value.data()), value.size() * sizeof(T))
+      );
+    } else {
+      std::size_t result = value.size();
+      for (const T& element : value) {
+        result ^= Hash()(element) + 0x9e3779b97f4a7c15 + (result << 6) + (result >> 2);
+      }
+      return result;
+    }
+  }
+
+private:
+  // Purging a table smaller than this isn't worth a pass over it
+  static constexpr std::size_t MIN_PURGE_SIZE = 64;
+
+  // The hash is computed once per entry, rehashing only reads it back
+  struct entry {
+    std::size_t hash;
+    vector_type value;
+
+    friend bool operator==(const entry& lhs, const entry& rhs) {
+      return lhs.hash == rhs.hash &&
+             (lhs.value.data() == rhs.value.data() || std::ranges::equal(lhs.value, rhs.value));
+    }
+  };
+
+  struct entry_hash {
+    std::size_t operator()(const entry& e) const noexcept {
+      return e.hash;
+    }
+  };
+
+  std::unordered_set<entry, entry_hash> _entries;
+  // Entries left by the last purge, and calls to `intern` since then
+  std::size_t _live = 0;
+  std::size_t _calls = 0;
+};
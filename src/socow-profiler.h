@@ -0,0 +1,359 @@
+#pragma once
+
+#include "socow-config.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <typeinfo>
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
+// Opt-in size-distribution profiling of socow_vector, enabled by defining SOCOW_PROFILE for the whole program.
+// Every vector is attributed to the instantiation and the source location it was constructed at.
+// The report is written at exit to the file named by the SOCOW_PROFILE_OUTPUT environment variable
+// (or to stderr), and can be requested at any time with `socow_profiler::report`.
+
+// Without SOCOW_PROFILE socow-config.h defines an empty socow_source_location and socow_profile_state.
+#ifdef SOCOW_PROFILE
+using socow_source_location = std::source_location;
+#endif
+
+// Statistics of the vectors of one instantiation constructed at one source location
+class socow_profile_site {
+public:
+  // Sizes up to MAX_EXACT_SIZE are counted exactly, larger ones in power-of-two buckets
+  static constexpr std::size_t MAX_EXACT_SIZE = 64;
+  static constexpr std::size_t BUCKETS = MAX_EXACT_SIZE + 1 + 64;
+
+  // A heap allocation is considered as expensive as this many bytes of footprint
+  static constexpr std::size_t ALLOCATION_COST = 64;
+
+  // Heap bytes spent on a buffer besides the elements: the vector header and the reference count
+  static constexpr std::size_t HEAP_OVERHEAD = 4 * sizeof(void*);
+
+  using histogram = std::array<std::atomic<std::size_t>, BUCKETS>;
+
+  struct estimate {
+    std::size_t small_size;
+    std::size_t allocations;
+    std::size_t footprint;
+  };
+
+  socow_profile_site(
+      std::string type,
+      std::size_t small_size,
+      std::size_t element_size,
+      std::size_t object_size,
+      std::string location
+  )
+      : _type(std::move(type))
+      , _location(std::move(location))
+      , _small_size(small_size)
+      , _element_size(element_size)
+      , _header_size(object_size - std::max(small_size * element_size, sizeof(void*))) {}
+
+  // Empty statistics of the same instantiation attributed to another location
+  socow_profile_site(const socow_profile_site& other, std::string location)
+      : _type(other._type)
+      , _location(std::move(location))
+      , _small_size(other._small_size)
+      , _element_size(other._element_size)
+      , _header_size(other._header_size) {}
+
+  const std::string& type() const noexcept {
+    return _type;
+  }
+
+  const std::string& location() const noexcept {
+    return _location;
+  }
+
+  void record_destruction(std::size_t peak_size, std::size_t final_size) noexcept {
+    _peak_sizes[bucket(peak_size)].fetch_add(1, std::memory_order_relaxed);
+    _final_sizes[bucket(final_size)].fetch_add(1, std::memory_order_relaxed);
+    _vectors.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void record_spill() noexcept {
+    _spills.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void record_unpin(std::size_t bytes) noexcept {
+    _unpins.fetch_add(1, std::memory_order_relaxed);
+    _unpinned_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  // Adds the statistics of `other` (of the same instantiation) to this one
+  void merge(const socow_profile_site& other) noexcept {
+    for (std::size_t i = 0; i != BUCKETS; ++i) {
+      _peak_sizes[i] += other._peak_sizes[i].load(std::memory_order_relaxed);
+      _final_sizes[i] += other._final_sizes[i].load(std::memory_order_relaxed);
+    }
+    _vectors += other._vectors.load(std::memory_order_relaxed);
+    _spills += other._spills.load(std::memory_order_relaxed);
+    _unpins += other._unpins.load(std::memory_order_relaxed);
+    _unpinned_bytes += other._unpinned_bytes.load(std::memory_order_relaxed);
+  }
+
+  // Heap allocations and total bytes the recorded vectors would have taken with the given SMALL_SIZE
+  estimate estimate_for(std::size_t small_size) const noexcept {
+    estimate result{small_size, 0, 0};
+    for (std::size_t i = 0; i != BUCKETS; ++i) {
+      std::size_t count = _peak_sizes[i].load(std::memory_order_relaxed);
+      if (count == 0) {
+        continue;
+      }
+      std::size_t peak = bucket_size(i);
+      result.footprint += count * (_header_size + std::max(small_size * _element_size, sizeof(void*)));
+      if (peak > small_size) {
+        // Spilling allocates the vector along with its reference count and the buffer of capacity
+        // 2 * SMALL_SIZE + 1, then the buffer grows as 2 * capacity + 1
+        std::size_t allocations = 2;
+        std::size_t capacity = 2 * small_size + 1;
+        for (; capacity < peak; capacity = 2 * capacity + 1) {
+          ++allocations;
+        }
+        result.allocations += count * allocations;
+        result.footprint += count * (capacity * _element_size + HEAP_OVERHEAD);
+      }
+    }
+    return result;
+  }
+
+  // SMALL_SIZE up to MAX_EXACT_SIZE that minimizes footprint + ALLOCATION_COST * allocations
+  std::size_t recommended_small_size() const noexcept {
+    std::size_t best = 0;
+    std::size_t best_cost = SIZE_MAX;
+    for (std::size_t small_size = 0; small_size <= MAX_EXACT_SIZE; ++small_size) {
+      estimate e = estimate_for(small_size);
+      std::size_t cost = e.footprint + ALLOCATION_COST * e.allocations;
+      if (cost < best_cost) {
+        best = small_size;
+        best_cost = cost;
+      }
+    }
+    return best;
+  }
+
+  void report(std::ostream& out) const {
+    out << _type << " at " << _location << '\n';
+    out << "  vectors: " << _vectors << ", spills: " << _spills << ", unpins: " << _unpins << " ("
+        << _unpinned_bytes << " bytes copied)\n";
+    print_histogram(out, "  peak size:", _peak_sizes);
+    print_histogram(out, "  size at destruction:", _final_sizes);
+
+    estimate current = estimate_for(_small_size);
+    estimate suggested = estimate_for(recommended_small_size());
+    out << "  SMALL_SIZE " << current.small_size << ": " << current.allocations << " allocations, "
+        << current.footprint << " bytes\n";
+    out << "  suggested SMALL_SIZE " << suggested.small_size << ": " << suggested.allocations << " allocations, "
+        << suggested.footprint << " bytes\n";
+  }
+
+private:
+  std::string _type;
+  std::string _location;
+  std::size_t _small_size;
+  std::size_t _element_size;
+  std::size_t _header_size;
+
+  histogram _peak_sizes{};
+  histogram _final_sizes{};
+  std::atomic<std::size_t> _vectors{0};
+  std::atomic<std::size_t> _spills{0};
+  std::atomic<std::size_t> _unpins{0};
+  std::atomic<std::size_t> _unpinned_bytes{0};
+
+  static std::size_t bucket(std::size_t size) noexcept {
+    if (size <= MAX_EXACT_SIZE) {
+      return size;
+    }
+    return MAX_EXACT_SIZE + 1 + static_cast<std::size_t>(std::bit_width(size) - std::bit_width(MAX_EXACT_SIZE + 1));
+  }
+
+  // The largest size that falls into the bucket
+  static std::size_t bucket_size(std::size_t bucket) noexcept {
+    if (bucket <= MAX_EXACT_SIZE) {
+      return bucket;
+    }
+    std::size_t bits = bucket - MAX_EXACT_SIZE - 1 + std::bit_width(MAX_EXACT_SIZE + 1);
+    return bits >= 64 ? SIZE_MAX : (std::size_t(1) << bits) - 1;
+  }
+
+  static void print_histogram(std::ostream& out, const char* title, const histogram& h) {
+    out << title;
+    for (std::size_t i = 0; i != BUCKETS; ++i) {
+      std::size_t count = h[i].load(std::memory_order_relaxed);
+      if (count == 0) {
+        continue;
+      }
+      if (i <= MAX_EXACT_SIZE) {
+        out << ' ' << i << ':' << count;
+      } else {
+        out << " <=" << bucket_size(i) << ':' << count;
+      }
+    }
+    out << '\n';
+  }
+};
+
+class socow_profiler {
+public:
+  // Sites are never destroyed, so vectors with static storage duration can outlive the report
+  static socow_profile_site& site(
+      const std::type_info& type,
+      std::size_t small_size,
+      std::size_t element_size,
+      std::size_t object_size,
+      const socow_source_location& location
+  ) {
+    socow_profiler& p = instance();
+    std::lock_guard lock(p._mutex);
+    std::unique_ptr<socow_profile_site>& site = p._sites[key(type, location)];
+    if (site == nullptr) {
+      site = std::make_unique<socow_profile_site>(
+          demangle(type),
+          small_size,
+          element_size,
+          object_size,
+          describe(location)
+      );
+    }
+    return *site;
+  }
+
+  // Writes the statistics of every instantiation and, if `per_location`, of every source location
+  static void report(std::ostream& out, bool per_location = true) {
+    socow_profiler& p = instance();
+    std::lock_guard lock(p._mutex);
+
+    std::map<const std::type_info*, std::unique_ptr<socow_profile_site>> totals;
+    for (const auto& [key, site] : p._sites) {
+      std::unique_ptr<socow_profile_site>& total = totals[std::get<0>(key)];
+      if (total == nullptr) {
+        total = std::make_unique<socow_profile_site>(*site, "all locations");
+      }
+      total->merge(*site);
+    }
+    for (const auto& [type, total] : totals) {
+      total->report(out);
+    }
+    if (per_location) {
+      for (const auto& [key, site] : p._sites) {
+        site->report(out);
+      }
+    }
+  }
+
+private:
+  // File names are string literals, so the key doesn't own them and a lookup doesn't allocate
+  using site_key = std::tuple<const std::type_info*, std::string_view, std::uint_least32_t, std::uint_least32_t>;
+
+  std::mutex _mutex;
+  std::map<site_key, std::unique_ptr<socow_profile_site>> _sites;
+
+  static socow_profiler& instance() {
+    static socow_profiler* profiler = [] {
+      std::atexit([] {
+        if (const char* path = std::getenv("SOCOW_PROFILE_OUTPUT")) {
+          std::ofstream out(path);
+          report(out);
+        } else {
+          report(std::cerr);
+        }
+      });
+      return new socow_profiler();
+    }();
+    return *profiler;
+  }
+
+  static site_key key(const std::type_info& type, [[maybe_unused]] const socow_source_location& location) {
+#ifdef SOCOW_PROFILE
+    return {&type, location.file_name(), location.line(), location.column()};
+#else
+    return {&type, {}, 0, 0};
+#endif
+  }
+
+  static std::string describe([[maybe_unused]] const socow_source_location& location) {
+#ifdef SOCOW_PROFILE
+    return std::string(location.file_name()) + ':' + std::to_string(location.line()) + ':' +
+           std::to_string(location.column());
+#else
+    return "unknown location";
+#endif
+  }
+
+  static std::string demangle(const std::type_info& type) {
+#if __has_include(<cxxabi.h>)
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    std::unique_ptr<char, decltype(&std::free)> name(demangled, &std::free);
+    if (status == 0 && name != nullptr) {
+      return name.get();
+    }
+#endif
+    return type.name();
+  }
+};
+
+// Per-vector profiling state
+#ifdef SOCOW_PROFILE
+class socow_profile_state {
+public:
+  template <typename Vector>
+  void attach(std::size_t small_size, std::size_t element_size, const socow_source_location& location) {
+    _site = &socow_profiler::site(typeid(Vector), small_size, element_size, sizeof(Vector), location);
+    _location = location;
+  }
+
+  const socow_source_location& location() const noexcept {
+    return _location;
+  }
+
+  void note_size(std::size_t size) noexcept {
+    _peak = std::max(_peak, size);
+  }
+
+  // Takes over the peak of the vector moved from, which is left with `other_size` elements,
+  // so that a peak reached before the move is recorded once
+  void move_from(socow_profile_state& other, std::size_t other_size) noexcept {
+    _peak = std::max(_peak, other._peak);
+    other._peak = other_size;
+  }
+
+  void record_spill() noexcept {
+    _site->record_spill();
+  }
+
+  void record_unpin(std::size_t bytes) noexcept {
+    _site->record_unpin(bytes);
+  }
+
+  void record_destruction(std::size_t size) noexcept {
+    _site->record_destruction(std::max(_peak, size), size);
+  }
+
+private:
+  socow_profile_site* _site = nullptr;
+  std::size_t _peak = 0;
+  socow_source_location _location;
+};
+#endif
@@ -0,0 +1,426 @@
+#pragma once
+
+#include "heap-storage.h"
+#include "shared-data.h"
+#include "socow-config.h"
+#include "vector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Immutable sequence stored as a balanced (AVL) tree whose leaves are slices of shared `vector<T>` buffers.
+// Nodes are never changed once built, so copies share the whole tree, and concatenation and splitting
+// build O(log N) new nodes without copying a single element.
+// Random access takes O(log N); iteration walks the leaves one contiguous segment at a time.
+template <typename T>
+class socow_rope {
+public:
+  using value_type = T;
+  using const_reference = const T&;
+  using const_pointer = const T*;
+
+  class const_iterator;
+  using iterator = const_iterator;
+
+public:
+  socow_rope() = default;
+
+  // O(1)
+  // Adopts the buffer of `leaf` without copying the elements
+  explicit socow_rope(vector<T>&& leaf) {
+    if (leaf.size() != 0) {
+      std::size_t size = leaf.size();
+      _root = make_leaf(shared_data<vector<T>>(std::move(leaf)), 0, size);
+    }
+  }
+
+  // O(N)
+  template <std::ranges::input_range R>
+    requires(!std::same_as<std::remove_cvref_t<R>, socow_rope>) &&
+            std::constructible_from<T, std::ranges::range_reference_t<R>>
+  explicit socow_rope(R&& range)
+      : socow_rope(collect(std::forward<R>(range))) {}
+
+  // O(N)
+  socow_rope(std::initializer_list<T> values)
+    requires std::copy_constructible<T>
+      : socow_rope(collect(values)) {}
+
+  // Fields access
+
+  // O(1) nothrow
+  std::size_t size() const noexcept {
+    return _root ? _root->size : 0;
+  }
+
+  // O(1) nothrow
+  bool empty() const noexcept {
+    return size() == 0;
+  }
+
+  // O(1) nothrow
+  // Height of the tree, at most about 1.44 log2 of the number of leaves
+  std::size_t height() const noexcept {
+    return height(_root);
+  }
+
+  // Element access
+
+  // O(log N) nothrow
+  const T& operator[](std::size_t index) const noexcept {
+    const node* current = &*_root;
+    while (!current->leaf()) {
+      std::size_t left_size = current->left->size;
+      if (index < left_size) {
+        current = &*current->left;
+      } else {
+        index -= left_size;
+        current = &*current->right;
+      }
+    }
+    return current->segment()[index];
+  }
+
+  // O(log N); strong
+  const T& at(std::size_t index) const {
+    if (index >= size()) {
+      socow_throw(std::out_of_range("socow_rope::at"));
+    }
+    return (*this)[index];
+  }
+
+  // O(log N) nothrow
+  const T& front() const noexcept {
+    return (*this)[0];
+  }
+
+  // O(log N) nothrow
+  const T& back() const noexcept {
+    return (*this)[size() - 1];
+  }
+
+  // Iteration
+
+  // O(log N); strong
+  const_iterator begin() const {
+    return const_iterator(_root);
+  }
+
+  // O(1) nothrow
+  const_iterator end() const noexcept {
+    return const_iterator();
+  }
+
+  // O(N + leaves)
+  // Calls `f(std::span<const T>)` for every leaf slice in order
+  template <typename F>
+  void for_each_segment(F&& f) const {
+    if (_root) {
+      for_each_segment(*_root, f);
+    }
+  }
+
+  // Concatenation and splitting
+
+  // O(log N); strong
+  socow_rope& append(const socow_rope& other) {
+    _root = join(_root, other._root);
+    return *this;
+  }
+
+  // O(log N); strong
+  socow_rope& operator+=(const socow_rope& other) {
+    return append(other);
+  }
+
+  // O(log N); strong
+  friend socow_rope operator+(socow_rope lhs, const socow_rope& rhs) {
+    lhs.append(rhs);
+    return lhs;
+  }
+
+  // O(log N); strong
+  // Returns the first `pos` elements and the rest
+  std::pair<socow_rope, socow_rope> split(std::size_t pos) const {
+    if (pos > size()) {
+      socow_throw(std::out_of_range("socow_rope::split"));
+    }
+    auto [left, right] = split(_root, pos);
+    return {socow_rope(std::move(left)), socow_rope(std::move(right))};
+  }
+
+  // O(log N); strong
+  socow_rope substr(std::size_t pos, std::size_t count = static_cast<std::size_t>(-1)) const {
+    socow_rope rest = split(pos).second;
+    count = std::min(count, rest.size());
+    return rest.split(count).first;
+  }
+
+  // O(log N); strong
+  // Inserts the elements of `other` before `pos`
+  void insert(std::size_t pos, const socow_rope& other) {
+    auto [left, right] = split(pos);
+    *this = left + other + right;
+  }
+
+  // O(log N); strong
+  // Removes `count` elements starting at `pos`
+  void erase(std::size_t pos, std::size_t count) {
+    auto [left, rest] = split(pos);
+    *this = left + rest.split(std::min(count, rest.size())).second;
+  }
+
+  // O(1) nothrow
+  void swap(socow_rope& other) noexcept {
+    using std::swap;
+    swap(_root, other._root);
+  }
+
+  friend void swap(socow_rope& lhs, socow_rope& rhs) noexcept {
+    lhs.swap(rhs);
+  }
+
+  // O(N) nothrow
+  friend bool operator==(const socow_rope& lhs, const socow_rope& rhs) {
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+  }
+
+private:
+  // A leaf is a slice of a shared buffer, an internal node has two children and no elements of its own
+  struct node {
+    node(shared_data<vector<T>> leaf_buffer, std::size_t leaf_offset, std::size_t leaf_size)
+        : size(leaf_size)
+        , height(1)
+        , buffer(std::move(leaf_buffer))
+        , offset(leaf_offset) {}
+
+    node(shared_data<node> left_child, shared_data<node> right_child)
+        : size(left_child->size + right_child->size)
+        , height(std::max(left_child->height, right_child->height) + 1)
+        , left(std::move(left_child))
+        , right(std::move(right_child)) {}
+
+    bool leaf() const noexcept {
+      return height == 1;
+    }
+
+    std::span<const T> segment() const noexcept {
+      return {buffer->data() + offset, size};
+    }
+
+    std::size_t size;
+    std::size_t height;
+    shared_data<node> left;
+    shared_data<node> right;
+    shared_data<vector<T>> buffer;
+    std::size_t offset = 0;
+  };
+
+  using tree = shared_data<node>;
+
+  explicit socow_rope(tree root)
+      : _root(std::move(root)) {}
+
+  template <typename R>
+  static vector<T> collect(R&& range) {
+    vector<T> leaf;
+    if constexpr (std::ranges::sized_range<R>) {
+      leaf.reserve(std::ranges::size(range));
+    }
+    for (auto&& value : range) {
+      leaf.push_back(T(std::forward<decltype(value)>(value)));
+    }
+    return leaf;
+  }
+
+  static std::size_t height(const tree& t) noexcept {
+    return t ? t->height : 0;
+  }
+
+  static tree make_leaf(shared_data<vector<T>> buffer, std::size_t offset, std::size_t size) {
+    return tree(std::move(buffer), offset, size);
+  }
+
+  static tree make_node(tree left, tree right) {
+    return tree(std::move(left), std::move(right));
+  }
+
+  // Rotations of the AVL tree; the rotated child is always an internal node
+  static tree rotate_left(const tree& t) {
+    const tree& r = t->right;
+    return make_node(make_node(t->left, r->left), r->right);
+  }
+
+  static tree rotate_right(const tree& t) {
+    const tree& l = t->left;
+    return make_node(l->left, make_node(l->right, t->right));
+  }
+
+  // Joins trees whose heights differ by more than one by descending the spine of the taller one:
+  // the AVL join algorithm, where the new internal node takes the place of the joining key
+  static tree join_right(const tree& left, const tree& right) {
+    const tree& l = left->left;
+    const tree& c = left->right;
+    if (height(c) <= height(right) + 1) {
+      tree joined = make_node(c, right);
+      if (height(joined) <= height(l) + 1) {
+        return make_node(l, std::move(joined));
+      }
+      return rotate_left(make_node(l, rotate_right(joined)));
+    }
+    tree joined = join_right(c, right);
+    tree result = make_node(l, joined);
+    if (height(joined) <= height(l) + 1) {
+      return result;
+    }
+    return rotate_left(result);
+  }
+
+  static tree join_left(const tree& left, const tree& right) {
+    const tree& c = right->left;
+    const tree& r = right->right;
+    if (height(c) <= height(left) + 1) {
+      tree joined = make_node(left, c);
+      if (height(joined) <= height(r) + 1) {
+        return make_node(std::move(joined), r);
+      }
+      return rotate_right(make_node(rotate_left(joined), r));
+    }
+    tree joined = join_left(left, c);
+    tree result = make_node(joined, r);
+    if (height(joined) <= height(r) + 1) {
+      return result;
+    }
+    return rotate_right(result);
+  }
+
+  // O(|height(left) - height(right)|)
+  static tree join(const tree& left, const tree& right) {
+    if (!left) {
+      return right;
+    }
+    if (!right) {
+      return left;
+    }
+    if (height(left) > height(right) + 1) {
+      return join_right(left, right);
+    }
+    if (height(right) > height(left) + 1) {
+      return join_left(left, right);
+    }
+    return make_node(left, right);
+  }
+
+  // O(log N): the joins on the way up cost a telescoping sum of height differences
+  static std::pair<tree, tree> split(const tree& t, std::size_t pos) {
+    if (pos == 0) {
+      return {tree(), t};
+    }
+    if (pos == t->size) {
+      return {t, tree()};
+    }
+    if (t->leaf()) {
+      return {make_leaf(t->buffer, t->offset, pos), make_leaf(t->buffer, t->offset + pos, t->size - pos)};
+    }
+    std::size_t left_size = t->left->size;
+    if (pos <= left_size) {
+      auto [left, right] = split(t->left, pos);
+      return {std::move(left), join(right, t->right)};
+    }
+    auto [left, right] = split(t->right, pos - left_size);
+    return {join(t->left, left), std::move(right)};
+  }
+
+  template <typename F>
+  static void for_each_segment(const node& n, F& f) {
+    if (n.leaf()) {
+      f(n.segment());
+    } else {
+      for_each_segment(*n.left, f);
+      for_each_segment(*n.right, f);
+    }
+  }
+
+  tree _root;
+};
+
+// Walks the leaves left to right, keeping the right subtrees still to visit on a stack
+template <typename T>
+class socow_rope<T>::const_iterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const T*;
+  using reference = const T&;
+
+public:
+  const_iterator() = default;
+
+  reference operator*() const noexcept {
+    return *_current;
+  }
+
+  pointer operator->() const noexcept {
+    return _current;
+  }
+
+  // O(1)*
+  const_iterator& operator++() {
+    if (++_current == _segment_end) {
+      next_leaf();
+    }
+    return *this;
+  }
+
+  const_iterator operator++(int) {
+    const_iterator result = *this;
+    ++*this;
+    return result;
+  }
+
+  friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) noexcept {
+    return lhs._current == rhs._current;
+  }
+
+private:
+  friend class socow_rope;
+
+  explicit const_iterator(const tree& root) {
+    if (root) {
+      _pending.push_back(&*root);
+      next_leaf();
+    }
+  }
+
+  void next_leaf() {
+    if (_pending.empty()) {
+      _current = nullptr;
+      _segment_end = nullptr;
+      return;
+    }
+    const node* n = _pending.back();
+    _pending.pop_back();
+    while (!n->leaf()) {
+      _pending.push_back(&*n->right);
+      n = &*n->left;
+    }
+    std::span<const T> segment = n->segment();
+    _current = segment.data();
+    _segment_end = segment.data() + segment.size();
+  }
+
+  const T* _current = nullptr;
+  const T* _segment_end = nullptr;
+  std::vector<const node*> _pending;
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "socow-config.h"
+#include "socow-vector.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Records of fields Ts... stored as a structure of arrays: every field has its own column,
+// a socow_vector<T, SMALL_SIZE>, so a scan over one field touches only that field's memory.
+// Columns are shared and unshared independently: modifying one field of a copy copies only that column.
+// Rows are accessed through tuples of references, which support structured bindings.
+// A bool field is stored one byte per flag (socow_vector<socow_byte_bool>), so that rows can refer to it as bool&.
+template <std::size_t SMALL_SIZE, typename... Ts>
+class socow_soa_vector {
+  static_assert(sizeof...(Ts) > 0, "a record needs at least one field");
+
+public:
+  using row = std::tuple<Ts&...>;
+  using const_row = std::tuple<const Ts&...>;
+
+  template <std::size_t I>
+  using column_type = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+  // Elements of the span returned by `column<I>()`: column_type<I>, or socow_byte_bool for a bool field
+  template <std::size_t I>
+  using column_element = socow_unpacked_t<column_type<I>>;
+
+public:
+  // Fields access
+
+  // O(1) nothrow
+  std::size_t size() const noexcept {
+    return std::get<0>(_columns).size();
+  }
+
+  // O(1) nothrow
+  bool empty() const noexcept {
+    return size() == 0;
+  }
+
+  // O(1) nothrow
+  std::size_t capacity() const noexcept {
+    return std::apply([](const auto&... columns) { return std::min({columns.capacity()...}); }, _columns);
+  }
+
+  // O(1) nothrow
+  template <std::size_t I>
+  std::span<const column_element<I>> column() const noexcept {
+    const auto& column = std::get<I>(_columns);
+    return {column.data(), column.size()};
+  }
+
+  // O(1) / O(size); strong
+  // Unshares only this column
+  template <std::size_t I>
+  std::span<column_element<I>> column() {
+    auto& column = std::get<I>(_columns);
+    return {column.data(), column.size()};
+  }
+
+  // Element access
+
+  // O(1) nothrow
+  const_row operator[](std::size_t index) const noexcept {
+    return std::apply([index](const auto&... columns) { return const_row(socow_unpack(columns[index])...); }, _columns);
+  }
+
+  // O(1) / O(size); strong
+  // Unshares every column
+  row operator[](std::size_t index) {
+    return std::apply([index](auto&... columns) { return row(socow_unpack(columns[index])...); }, _columns);
+  }
+
+  // O(1) nothrow
+  const_row front() const noexcept {
+    return (*this)[0];
+  }
+
+  // O(1) nothrow
+  const_row back() const noexcept {
+    return (*this)[size() - 1];
+  }
+
+  // Operations
+
+  // O(1)*; strong
+  // Columns that already took their field give it back if a later one throws
+  void push_back(Ts... values) {
+    std::size_t pushed = 0;
+    SOCOW_TRY {
+      std::apply([&](auto&... columns) { ((columns.push_back(std::move(values)), ++pushed), ...); }, _columns);
+    }
+    SOCOW_CATCH_ALL {
+      std::size_t index = 0;
+      for_each_column(_columns, [&](auto& column) {
+        if (index++ < pushed) {
+          column.pop_back();
+        }
+      });
+      SOCOW_RETHROW;
+    }
+  }
+
+  // O(1) / O(size); strong
+  // Every column is unshared before any is popped: only the copies can throw, and popping an unshared one can't
+  void pop_back() {
+    for_each_column(_columns, [](auto& column) { column.data(); });
+    for_each_column(_columns, [](auto& column) { column.pop_back(); });
+  }
+
+  // O(size); strong
+  void reserve(std::size_t new_capacity) {
+    for_each_column(_columns, [new_capacity](auto& column) { column.reserve(new_capacity); });
+  }
+
+  // O(size); nothrow
+  void clear() noexcept {
+    for_each_column(_columns, [](auto& column) { column.clear(); });
+  }
+
+  // O(SMALL_SIZE); nothrow
+  void swap(socow_soa_vector& other) noexcept {
+    _columns.swap(other._columns);
+  }
+
+  friend void swap(socow_soa_vector& lhs, socow_soa_vector& rhs) noexcept {
+    lhs.swap(rhs);
+  }
+
+  // Sum of the memory usage of the columns, with the inline bytes of the whole container
+  socow_memory_usage memory_usage() const {
+    socow_memory_usage result;
+    for_each_column(_columns, [&result](const auto& column) {
+      socow_memory_usage usage = column.memory_usage();
+      result.heap_bytes += usage.heap_bytes;
+      result.shared_bytes += usage.shared_bytes;
+    });
+    result.inline_bytes = sizeof(socow_soa_vector);
+    return result;
+  }
+
+private:
+  template <typename Columns, typename F>
+  static void for_each_column(Columns& columns, F f) {
+    std::apply([&f](auto&... column) { (f(column), ...); }, columns);
+  }
+
+  std::tuple<socow_vector<socow_unpacked_t<Ts>, SMALL_SIZE>...> _columns;
+};
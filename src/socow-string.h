@@ -0,0 +1,365 @@
+#pragma once
+
+#include "socow-config.h"
+#include "socow-vector.h"
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#ifdef __linux__
+#include <string.h>
+#endif
+
+// String of chars with the small-object and copy-on-write optimizations of socow_vector<char>:
+// strings of up to SMALL_SIZE chars are stored inline and copies of longer ones share a buffer.
+// The buffer always holds a terminating '\0' after the chars, so `c_str()` is free.
+// Read-only access never unshares the buffer: prefer `view()`, `c_str()` and the const overloads.
+template <std::size_t SMALL_SIZE = socow_small_size<char>() - 1>
+class basic_socow_string {
+public:
+  using value_type = char;
+  using size_type = std::size_t;
+
+  using reference = char&;
+  using const_reference = const char&;
+
+  using pointer = char*;
+  using const_pointer = const char*;
+
+  using iterator = pointer;
+  using const_iterator = const_pointer;
+
+  static constexpr std::size_t npos = std::string_view::npos;
+
+public:
+  basic_socow_string() {
+    _chars.push_back('\0');
+  }
+
+  // O(N)
+  basic_socow_string(const char* chars)
+      : basic_socow_string(std::string_view(chars)) {}
+
+  // O(N)
+  explicit basic_socow_string(std::string_view chars) {
+    _chars.reserve(chars.size() + 1);
+    _chars.push_back('\0');
+    append(chars);
+  }
+
+  // O(N)
+  basic_socow_string(std::size_t count, char ch) {
+    _chars.reserve(count + 1);
+    _chars.push_back('\0');
+    append(count, ch);
+  }
+
+  // Fields access
+
+  // O(1) nothrow
+  std::size_t size() const noexcept {
+    return _chars.size() - 1;
+  }
+
+  // O(1) nothrow
+  std::size_t length() const noexcept {
+    return size();
+  }
+
+  // O(1) nothrow
+  bool empty() const noexcept {
+    return size() == 0;
+  }
+
+  // O(1) nothrow
+  std::size_t capacity() const noexcept {
+    return _chars.capacity() - 1;
+  }
+
+  // O(1) nothrow
+  const char* c_str() const noexcept {
+    return _chars.data();
+  }
+
+  // O(1) nothrow
+  const char* data() const noexcept {
+    return _chars.data();
+  }
+
+  // O(1) / O(size); strong
+  char* data() {
+    return _chars.data();
+  }
+
+  // O(1) nothrow
+  std::string_view view() const noexcept {
+    return {data(), size()};
+  }
+
+  // O(1) nothrow
+  operator std::string_view() const noexcept {
+    return view();
+  }
+
+  // Element access
+
+  // O(1) nothrow
+  const char& operator[](std::size_t index) const noexcept {
+    return _chars[index];
+  }
+
+  // O(1) / O(size); strong
+  char& operator[](std::size_t index) {
+    return _chars[index];
+  }
+
+  // O(1) nothrow
+  const char& front() const noexcept {
+    return _chars.front();
+  }
+
+  // O(1) nothrow
+  const char& back() const noexcept {
+    return _chars[size() - 1];
+  }
+
+  // Iterators
+
+  // O(1) nothrow
+  const_iterator begin() const noexcept {
+    return _chars.begin();
+  }
+
+  // O(1) nothrow
+  const_iterator end() const noexcept {
+    return begin() + size();
+  }
+
+  // O(1) / O(size); strong
+  iterator begin() {
+    return _chars.begin();
+  }
+
+  // O(1) / O(size); strong
+  iterator end() {
+    return begin() + size();
+  }
+
+  // Modifiers
+
+  // O(count)*; strong
+  // A shared buffer is copied once, straight into a buffer with room for the new chars.
+  // `chars` may point into this string.
+  basic_socow_string& append(std::string_view chars) {
+    if (chars.empty()) {
+      return *this;
+    }
+    const char* old_data = std::as_const(_chars).data();
+    bool inside = !std::less<>()(chars.data(), old_data) && std::less<>()(chars.data(), old_data + size());
+    std::size_t offset = inside ? chars.data() - old_data : 0;
+    std::size_t old_size = size();
+    _chars.append_uninitialized(chars.size(), [&](char* tail) {
+      // `tail` is past the old terminator, which the appended chars overwrite
+      char* first = tail - old_size - 1;
+      std::memmove(first + old_size, inside ? first + offset : chars.data(), chars.size());
+      first[old_size + chars.size()] = '\0';
+    });
+    return *this;
+  }
+
+  // O(count)*; strong
+  basic_socow_string& append(std::size_t count, char ch) {
+    if (count == 0) {
+      return *this;
+    }
+    _chars.append_uninitialized(count, [&](char* tail) {
+      std::memset(tail - 1, ch, count);
+      tail[count - 1] = '\0';
+    });
+    return *this;
+  }
+
+  // O(1)*; strong
+  void push_back(char ch) {
+    append(1, ch);
+  }
+
+  // O(1) / O(size); strong
+  void pop_back() {
+    _chars.pop_back();
+    _chars.back() = '\0';
+  }
+
+  // O(count)*; strong
+  basic_socow_string& operator+=(std::string_view chars) {
+    return append(chars);
+  }
+
+  // O(1)*; strong
+  basic_socow_string& operator+=(char ch) {
+    return append(1, ch);
+  }
+
+  // O(1) / O(size); nothrow
+  void clear() noexcept {
+    _chars.clear();
+    _chars.push_back('\0');
+  }
+
+  // O(size); strong
+  void reserve(std::size_t new_capacity) {
+    _chars.reserve(new_capacity + 1);
+  }
+
+  // O(count); strong
+  void resize(std::size_t count, char ch = '\0') {
+    if (count > size()) {
+      append(count - size(), ch);
+    } else if (count < size()) {
+      _chars.resize_for_overwrite(count + 1);
+      _chars[count] = '\0';
+    }
+  }
+
+  // O(1) nothrow
+  void swap(basic_socow_string& other) noexcept {
+    _chars.swap(other._chars);
+  }
+
+  friend void swap(basic_socow_string& lhs, basic_socow_string& rhs) noexcept {
+    lhs.swap(rhs);
+  }
+
+  // Search
+
+  // O(size) nothrow
+  // Uses memchr, which libc implements with vector instructions
+  std::size_t find(char ch, std::size_t pos = 0) const noexcept {
+    if (pos >= size()) {
+      return npos;
+    }
+    const void* found = std::memchr(data() + pos, ch, size() - pos);
+    return found == nullptr ? npos : static_cast<const char*>(found) - data();
+  }
+
+  // O(size + needle) nothrow
+  // Jumps between occurrences of the first char with memchr and compares the rest with memcmp.
+  // If that keeps failing, the rest is left to memmem where it is available:
+  // glibc implements it with the two-way algorithm, which is linear in the worst case.
+  std::size_t find(std::string_view needle, std::size_t pos = 0) const noexcept {
+    if (pos > size() || needle.size() > size() - pos) {
+      return npos;
+    }
+    if (needle.empty()) {
+      return pos;
+    }
+    const char* first = data() + pos;
+    const char* last = data() + size() - needle.size() + 1;
+#ifdef __linux__
+    std::size_t false_starts = 0;
+#endif
+    while (first != last) {
+      first = static_cast<const char*>(std::memchr(first, needle[0], last - first));
+      if (first == nullptr) {
+        return npos;
+      }
+      if (std::memcmp(first + 1, needle.data() + 1, needle.size() - 1) == 0) {
+        return first - data();
+      }
+      ++first;
+#ifdef __linux__
+      if (++false_starts == MAX_FALSE_STARTS) {
+        const void* found = ::memmem(first, data() + size() - first, needle.data(), needle.size());
+        return found == nullptr ? npos : static_cast<const char*>(found) - data();
+      }
+#endif
+    }
+    return npos;
+  }
+
+  // O(size + needle) nothrow
+  bool contains(std::string_view needle) const noexcept {
+    return find(needle) != npos;
+  }
+
+  // O(prefix) nothrow
+  bool starts_with(std::string_view prefix) const noexcept {
+    return view().starts_with(prefix);
+  }
+
+  // O(suffix) nothrow
+  bool ends_with(std::string_view suffix) const noexcept {
+    return view().ends_with(suffix);
+  }
+
+  // O(count); strong
+  basic_socow_string substr(std::size_t pos = 0, std::size_t count = npos) const {
+    if (pos > size()) {
+      socow_throw(std::out_of_range("basic_socow_string::substr"));
+    }
+    return basic_socow_string(view().substr(pos, count));
+  }
+
+  // O(N) nothrow
+  friend bool operator==(const basic_socow_string& lhs, std::string_view rhs) noexcept {
+    return lhs.view() == rhs;
+  }
+
+  // O(N) nothrow
+  friend std::strong_ordering operator<=>(const basic_socow_string& lhs, std::string_view rhs) noexcept {
+    return lhs.view() <=> rhs;
+  }
+
+  // O(N); strong
+  friend basic_socow_string operator+(const basic_socow_string& lhs, std::string_view rhs) {
+    basic_socow_string result;
+    result.reserve(lhs.size() + rhs.size());
+    result.append(lhs.view());
+    result.append(rhs);
+    return result;
+  }
+
+  // O(rhs)*; strong
+  // Appends in place when `lhs` is a temporary, like `a + b + c`
+  friend basic_socow_string operator+(basic_socow_string&& lhs, std::string_view rhs) {
+    lhs.append(rhs);
+    return std::move(lhs);
+  }
+
+  friend std::ostream& operator<<(std::ostream& out, const basic_socow_string& s) {
+    return out << s.view();
+  }
+
+  // Same as socow_vector::memory_usage, with the inline bytes of the whole string
+  socow_memory_usage memory_usage() const {
+    socow_memory_usage result = _chars.memory_usage();
+    result.inline_bytes = sizeof(basic_socow_string);
+    return result;
+  }
+
+private:
+  // Failed candidates after which `find` switches to a search with a linear worst case
+  static constexpr std::size_t MAX_FALSE_STARTS = 16;
+
+  socow_vector<char, SMALL_SIZE + 1> _chars;
+};
+
+using socow_string = basic_socow_string<>;
+
+namespace std {
+
+template <std::size_t SMALL_SIZE>
+struct hash<basic_socow_string<SMALL_SIZE>> {
+  std::size_t operator()(const basic_socow_string<SMALL_SIZE>& s) const noexcept {
+    return std::hash<std::string_view>()(s.view());
+  }
+};
+
+} // namespace std
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "shared-data.h"
+#include "socow-config.h"
+#include "socow-vector.h"
+#include "vector.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Collects the elements of a socow_vector from several threads at once.
+// Every producer appends to its own chunk, so appending takes no locks, and chunks are padded to a cache line,
+// so producers don't write to a shared line either. `finish()` allocates the buffer of the result once,
+// sized to the total, and relocates the chunks into it in chunk order, splitting the copying between threads.
+template <typename T, std::size_t SMALL_SIZE, typename Storage>
+class socow_vector<T, SMALL_SIZE, Storage>::builder {
+public:
+  using chunk = vector<T, Storage>;
+
+public:
+  // O(chunk_count); strong
+  explicit builder(std::size_t chunk_count)
+      : _chunks(chunk_count) {}
+
+  // O(1) nothrow
+  std::size_t chunk_count() const noexcept {
+    return _chunks.size();
+  }
+
+  // O(1) nothrow
+  // Different chunks may be filled from different threads at the same time
+  chunk& operator[](std::size_t index) noexcept {
+    return _chunks[index].elements;
+  }
+
+  // O(1) nothrow
+  const chunk& operator[](std::size_t index) const noexcept {
+    return _chunks[index].elements;
+  }
+
+  // O(chunk_count) nothrow
+  std::size_t size() const noexcept {
+    std::size_t total = 0;
+    for (const padded_chunk& c : _chunks) {
+      total += c.elements.size();
+    }
+    return total;
+  }
+
+  // O(N / threads + chunk_count); strong
+  // Concatenates the chunks into one vector and leaves them empty. Must not run concurrently with the producers.
+  // Up to `max_threads` threads (the calling one included) relocate the elements if there are enough of them;
+  // elements whose move may throw are copied on the calling thread instead, which keeps the chunks intact on failure.
+  socow_vector finish(
+      std::size_t max_threads = std::thread::hardware_concurrency(),
+      socow_source_location location = socow_source_location::current()
+  ) {
+    socow_vector result(location);
+    std::size_t total = size();
+    if (total <= SMALL_SIZE) {
+      for (padded_chunk& c : _chunks) {
+        for (T& value : c.elements) {
+          result.push_back(std::move_if_noexcept(value));
+        }
+      }
+      clear();
+      return result;
+    }
+
+    // Everything that may fail is allocated before the first element leaves its chunk
+    shared_data<chunk> buffer(chunk{});
+    buffer->reserve(total);
+    if constexpr (PARALLEL_RELOCATION) {
+      relocate(buffer->data(), total, max_threads);
+      buffer->commit_tail(total);
+    } else {
+      for (padded_chunk& c : _chunks) {
+        for (T& value : c.elements) {
+          buffer->push_back(std::move_if_noexcept(value));
+        }
+      }
+    }
+
+    result.begin_dynamic(std::move(buffer));
+    result._profile.note_size(total);
+    clear();
+    return result;
+  }
+
+  // O(N) nothrow
+  // Destroys the elements and frees the chunks
+  void clear() noexcept {
+    for (padded_chunk& c : _chunks) {
+      c.elements = chunk();
+    }
+  }
+
+private:
+  // Chunks written by different threads never share a cache line
+  struct alignas(SOCOW_CACHE_LINE_SIZE) padded_chunk {
+    chunk elements;
+  };
+
+  // Relocation on other threads must not throw: there would be no way to undo the pieces already moved
+  static constexpr bool PARALLEL_RELOCATION = std::is_nothrow_move_constructible_v<T> || !SOCOW_EXCEPTIONS;
+
+  // Starting a thread costs about as much as copying this many bytes
+  static constexpr std::size_t MIN_PIECE_BYTES = 256 * 1024;
+
+  std::vector<padded_chunk> _chunks;
+
+  // O(N / threads + chunk_count); strong
+  // Splits the result into equal pieces, which may span several chunks, and moves each piece on its own thread.
+  // A piece whose thread fails to start is moved on the calling thread.
+  void relocate(pointer out, std::size_t total, std::size_t max_threads) {
+    std::vector<std::size_t> offsets(_chunks.size() + 1, 0);
+    for (std::size_t i = 0; i != _chunks.size(); ++i) {
+      offsets[i + 1] = offsets[i] + _chunks[i].elements.size();
+    }
+    std::size_t pieces = std::min(std::max<std::size_t>(total * sizeof(T) / MIN_PIECE_BYTES, 1), max_threads);
+    pieces = std::max<std::size_t>(pieces, 1);
+    std::vector<std::thread> workers;
+    workers.reserve(pieces - 1);
+
+    auto relocate_piece = [&](std::size_t piece) noexcept {
+      std::size_t first = total * piece / pieces;
+      std::size_t last = total * (piece + 1) / pieces;
+      std::size_t c = std::upper_bound(offsets.begin(), offsets.end(), first) - offsets.begin() - 1;
+      for (; first != last; ++c) {
+        std::size_t count = std::min(last, offsets[c + 1]) - first;
+        if (count == 0) {
+          continue;
+        }
+        T* source = _chunks[c].elements.data() + (first - offsets[c]);
+        if constexpr (std::is_trivially_copyable_v<T>) {
+          std::memcpy(out + first, source, count * sizeof(T));
+        } else {
+          std::uninitialized_move_n(source, count, out + first);
+        }
+        first += count;
+      }
+    };
+
+    std::size_t piece = 1;
+    SOCOW_TRY {
+      for (; piece != pieces; ++piece) {
+        workers.emplace_back(relocate_piece, piece);
+      }
+    }
+    SOCOW_CATCH_ALL {}
+    relocate_piece(0);
+    for (; piece != pieces; ++piece) {
+      relocate_piece(piece);
+    }
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+  }
+};
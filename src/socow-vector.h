@@ -1,16 +1,124 @@
 #pragma once
 
+#include "heap-storage.h"
 #include "shared-data.h"
+#include "socow-config.h"
 #include "vector.h"
 
+#ifdef SOCOW_PROFILE
+#include "socow-profiler.h"
+#endif
+
+// The file descriptor overloads of append_from and write_to need POSIX read and write
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#define SOCOW_FD_IO
+#endif
+
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cerrno>
+#include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
 #include <iterator>
 #include <memory>
+#include <system_error>
+#include <type_traits>
+#include <utility>
 
+// Cache line size the default SMALL_SIZE is chosen for
+inline constexpr std::size_t SOCOW_CACHE_LINE_SIZE = 64;
+
+// Mirrors the layout of socow_vector<T, SMALL_SIZE> (without the profiling state, which must not affect the default)
 template <typename T, std::size_t SMALL_SIZE>
-class socow_vector {
+struct socow_layout {
+  std::size_t size;
+
+  union {
+    shared_data<vector<T>> dynamic_data;
+    std::array<T, SMALL_SIZE> static_data;
+  };
+};
+
+// The largest SMALL_SIZE for which socow_vector<T, SMALL_SIZE> takes at most BYTES bytes, 0 if there is none.
+// The search starts from the capacity of the bytes left after the size field and goes down,
+// which takes a step or two since only padding separates the estimate from the answer.
+template <typename T, std::size_t BYTES = SOCOW_CACHE_LINE_SIZE,
+          std::size_t N = (std::max(BYTES, sizeof(std::size_t)) - sizeof(std::size_t)) / sizeof(T)>
+constexpr std::size_t socow_small_size() {
+  if constexpr (N == 0 || sizeof(socow_layout<T, N>) <= BYTES) {
+    return N;
+  } else {
+    return socow_small_size<T, BYTES, N - 1>();
+  }
+}
+
+// Default SMALL_SIZE of socow_vector<T>. socow_vector<bool> packs its elements into 64-bit words,
+// so its default counts the bits of as many words as fit; other containers of bool still count bytes.
+template <typename T>
+constexpr std::size_t socow_vector_small_size() {
+  if constexpr (std::is_same_v<T, bool>) {
+    return socow_small_size<std::uint64_t>() * 64;
+  } else {
+    return socow_small_size<T>();
+  }
+}
+
+// Memory taken by an object. A heap block shared by several owners counts fully in the `heap_bytes` of each of them
+// and is split evenly between them in `shared_bytes`, so that the shared bytes of all owners add up to the real usage.
+struct socow_memory_usage {
+  std::size_t inline_bytes = 0;
+  std::size_t heap_bytes = 0;
+  double shared_bytes = 0;
+};
+
+template <typename T>
+concept socow_memory_reporting = requires(const T& value) {
+  { value.memory_usage() } -> std::same_as<socow_memory_usage>;
+};
+
+// Default visitor for the elements of a socow_vector: asks the ones that can report their memory usage
+struct socow_element_usage {
+  template <typename T>
+  socow_memory_usage operator()(const T& value) const {
+    if constexpr (socow_memory_reporting<T>) {
+      return value.memory_usage();
+    } else {
+      return {};
+    }
+  }
+};
+
+// Data members of socow_vector. While `_size` is at most SMALL_SIZE the elements are inline in `_static_data`,
+// otherwise `_size` is SMALL_SIZE + 1 and they are in the heap buffer `_dynamic_data`.
+// socow_vector sets the size and starts and ends the members of the union itself.
+template <typename T, std::size_t SMALL_SIZE, typename Storage>
+struct socow_vector_fields {
+  constexpr socow_vector_fields() noexcept {}
+
+  constexpr ~socow_vector_fields() {}
+
+  std::size_t _size;
+
+  union {
+    shared_data<vector<T, Storage>> _dynamic_data;
+    std::array<T, SMALL_SIZE> _static_data;
+  };
+};
+
+// Without an inline buffer there is neither a size nor a union: the elements are always in the heap buffer,
+// and an empty vector has no buffer at all
+template <typename T, typename Storage>
+struct socow_vector_fields<T, 0, Storage> {
+  shared_data<vector<T, Storage>> _dynamic_data;
+};
+
+template <typename T, std::size_t SMALL_SIZE = socow_vector_small_size<T>(), typename Storage = heap_storage>
+class socow_vector : public socow_vector_fields<T, SMALL_SIZE, Storage> {
 public:
   using value_type = T;
 
@@ -23,388 +131,881 @@ public:
   using iterator = pointer;
   using const_iterator = const_pointer;
 
+  // Parallel construction from per-thread chunks, see socow-vector-builder.h
+  class builder;
+
 public:
-  socow_vector()
-      : _size(0) {}
+  // O(1) nothrow
+  // Profiled builds attribute default-constructed vectors to this line, pass a location to attribute them elsewhere
+  constexpr socow_vector() noexcept
+      : socow_vector(socow_source_location::current()) {}
+
+  // `location` attributes the vector to its construction site when SOCOW_PROFILE is defined.
+  // Explicit, so that a source location doesn't convert to an empty vector.
+  explicit constexpr socow_vector(socow_source_location location) {
+    if constexpr (!PURE_COW) {
+      this->_size = 0;
+    }
+    begin_static();
+    attach(location);
+  }
 
   // O(SMALL_SIZE) / O(1); strong / nothrow
-  socow_vector(const socow_vector& other)
-      : _size(other._size) {
-    if (other.small_object()) {
-      for (std::size_t i = 0; i != other._size; ++i) {
-        new (_static_data.data() + i) value_type(other._static_data[i]);
-      }
-    } else {
-      _dynamic_data._data = nullptr;
-      _dynamic_data._count = nullptr;
-      _dynamic_data = other._dynamic_data;
+  constexpr socow_vector(
+      const socow_vector& other,
+      socow_source_location location = socow_source_location::current()
+  )
+    requires std::copy_constructible<T>
+  {
+    attach(location);
+    if (!other.small_object()) {
+      begin_dynamic(other._dynamic_data);
+    } else if constexpr (!PURE_COW) {
+      begin_static();
+      copy_static(other);
+      this->_size = other._size;
     }
+    _profile.note_size(size());
   }
 
-  socow_vector(socow_vector&& other) noexcept
-      : _size(0) {
-    using std::swap;
-    if (other.small_object()) {
-      swap(_static_data, other._static_data);
-    } else {
-      _dynamic_data._data = nullptr;
-      _dynamic_data._count = nullptr;
-      swap(_dynamic_data, other._dynamic_data);
+  // O(SMALL_SIZE) / O(1); nothrow / nothrow
+  constexpr socow_vector(
+      socow_vector&& other,
+      socow_source_location location = socow_source_location::current()
+  ) noexcept {
+    attach(location);
+    if (!other.small_object()) {
+      begin_dynamic(std::move(other._dynamic_data));
+      other.end_dynamic();
+    } else if constexpr (!PURE_COW) {
+      begin_static();
+      relocate_static(other, *this);
+      this->_size = std::exchange(other._size, 0);
     }
-    swap(_size, other._size);
+    _profile.note_size(size());
+    _profile.move_from(other._profile, 0);
   }
 
   // O(SMALL_SIZE) / O(1); strong / nothrow
-  socow_vector& operator=(const socow_vector& other) {
+  constexpr socow_vector& operator=(const socow_vector& other)
+    requires std::copy_constructible<T>
+  {
     if (this != &other) {
-      socow_vector copy(other);
+      socow_vector copy(other, _profile.location());
       swap(copy);
     }
     return *this;
   }
 
   // O(SMALL_SIZE) / O(1); nothrow / nothrow
-  socow_vector& operator=(socow_vector&& other) noexcept {
+  constexpr socow_vector& operator=(socow_vector&& other) noexcept {
     if (this != &other) {
       swap(other);
+      _profile.move_from(other._profile, other.size());
     }
     return *this;
   }
 
   // ???
-  ~socow_vector() {
-    if (small_object()) {
-      std::destroy(begin(), end());
-    } else {
-      _dynamic_data.~shared_data();
+  constexpr ~socow_vector() {
+    _profile.record_destruction(size());
+    // Without an inline buffer the heap buffer is a plain member, destroyed along with the fields
+    if constexpr (!PURE_COW) {
+      if (small_object()) {
+        std::destroy(begin(), end());
+      } else {
+        _dynamic_data.~shared_data();
+      }
     }
   }
 
   // Fields access
 
   // O(1) / O(1); nothrow / nothrow
-  std::size_t size() const noexcept {
-    return small_object() ? _size : _dynamic_data->size();
+  constexpr std::size_t size() const noexcept {
+    if constexpr (PURE_COW) {
+      return _dynamic_data ? _dynamic_data->size() : 0;
+    } else {
+      return small_object() ? this->_size : _dynamic_data->size();
+    }
   }
 
   // O(1) / O(1); nothrow / nothrow
-  bool empty() const noexcept {
+  constexpr bool empty() const noexcept {
     return size() == 0;
   }
 
   // O(1) / O(1); nothrow / nothrow
-  std::size_t capacity() const noexcept {
-    return small_object() ? SMALL_SIZE : _dynamic_data->capacity();
+  constexpr std::size_t capacity() const noexcept {
+    if constexpr (PURE_COW) {
+      return _dynamic_data ? _dynamic_data->capacity() : 0;
+    } else {
+      return small_object() ? SMALL_SIZE : _dynamic_data->capacity();
+    }
   }
 
   // O(1) / O(size); nothrow / strong
-  pointer data() {
-    if (small_object()) {
-      return _static_data.data();
-    } else {
-      unpin();
-      return _dynamic_data->data();
+  constexpr pointer data() {
+    if constexpr (!PURE_COW) {
+      if (small_object()) {
+        return this->_static_data.data();
+      }
+    } else if (!_dynamic_data) {
+      return nullptr;
     }
+    unpin();
+    return _dynamic_data->data();
   }
 
   // O(1) / O(1); nothrow / nothrow
-  const_pointer data() const noexcept {
-    if (small_object()) {
-      return _static_data.data();
-    } else {
-      return _dynamic_data->data();
+  constexpr const_pointer data() const noexcept {
+    if constexpr (!PURE_COW) {
+      if (small_object()) {
+        return this->_static_data.data();
+      }
+    } else if (!_dynamic_data) {
+      return nullptr;
     }
+    return std::as_const(*_dynamic_data).data();
   }
 
   // Operations
 
   // O(1) / O(1)*; strong / strong
-  void push_back(const T& value) {
+  constexpr void push_back(const T& value)
+    requires std::copy_constructible<T>
+  {
     value_type v = value;
     push_back(std::move(v));
   }
 
   // O(1) / O(1)*; nothrow / strong
-  void push_back(T&& value) {
-    if (small_object() && !full()) {
-      new (_static_data.data() + _size) value_type(std::move(value));
-      ++_size;
-    } else {
-      if (full()) {
-        change_storage();
+  constexpr void push_back(T&& value) {
+    if constexpr (!PURE_COW) {
+      if (small_object() && !full()) [[likely]] {
+        std::construct_at(this->_static_data.data() + this->_size, std::move(value));
+        ++this->_size;
+        _profile.note_size(this->_size);
+        return;
       }
-      unpin();
-      _dynamic_data->push_back(std::move(value));
     }
+    if (full()) [[unlikely]] {
+      change_storage(2 * SMALL_SIZE + 1);
+    }
+    unpin();
+    _dynamic_data->push_back(std::move(value));
+    _profile.note_size(size());
   }
 
   // O(1) / O(1); nothrow / strong
-  void pop_back() {
-    if (small_object()) {
-      data()[_size - 1].~value_type();
-      --_size;
-    } else {
-      unpin();
-      _dynamic_data->pop_back();
+  constexpr void pop_back() {
+    if constexpr (!PURE_COW) {
+      if (small_object()) {
+        std::destroy_at(this->_static_data.data() + this->_size - 1);
+        --this->_size;
+        return;
+      }
     }
+    unpin();
+    _dynamic_data->pop_back();
   }
 
   // O(1) / O(1)*; strong / strong
-  iterator insert(const_iterator pos, const T& value) {
+  constexpr iterator insert(const_iterator pos, const T& value)
+    requires std::copy_constructible<T>
+  {
     value_type v = value;
     return insert(pos, std::move(v));
   }
 
   // O(1) / O(1)*; nothrow / strong
-  iterator insert(const_iterator pos, T&& value) {
+  constexpr iterator insert(const_iterator pos, T&& value) {
     std::size_t idx = pos - begin();
-    if (small_object() && !full()) {
-      new (_static_data.data() + _size) T(std::move(value));
-      ++_size;
-      iterator it = end() - 1;
-      while (it != begin() + idx) {
-        std::iter_swap(it - 1, it);
-        --it;
+    if constexpr (!PURE_COW) {
+      if (small_object() && !full()) [[likely]] {
+        std::construct_at(this->_static_data.data() + this->_size, std::move(value));
+        ++this->_size;
+        iterator it = end() - 1;
+        while (it != begin() + idx) {
+          std::iter_swap(it - 1, it);
+          --it;
+        }
+        _profile.note_size(this->_size);
+        return begin() + idx;
       }
-      return begin() + idx;
     }
-    if (full()) {
-      change_storage();
+    if (full()) [[unlikely]] {
+      change_storage(2 * SMALL_SIZE + 1);
     }
     unpin();
-    return _dynamic_data->insert(begin() + idx, std::move(value));
+    iterator result = _dynamic_data->insert(begin() + idx, std::move(value));
+    _profile.note_size(size());
+    return result;
   }
 
   // O(SMALL_SIZE) / O(N); nothrow / nothrow
-  iterator erase(const_iterator pos) noexcept {
+  constexpr iterator erase(const_iterator pos) noexcept {
     return erase(pos, pos + 1);
   }
 
   // O(SMALL_SIZE) / O(N); nothrow / nothrow
-  iterator erase(const_iterator first, const_iterator last) noexcept {
+  constexpr iterator erase(const_iterator first, const_iterator last) noexcept {
     if (first == last) {
       return begin() + (last - begin());
     }
 
-    if (small_object()) {
-      size_t idx = first - begin();
-      iterator left = begin() + (first - begin());
-      iterator right = begin() + (last - begin());
+    if constexpr (!PURE_COW) {
+      if (small_object()) {
+        size_t idx = first - begin();
+        iterator left = begin() + (first - begin());
+        iterator right = begin() + (last - begin());
 
-      while (right != end()) {
-        std::iter_swap(left, right);
-        ++right;
-        ++left;
-      }
-      for (; left != end(); ++left) {
-        left->~value_type();
-      }
+        while (right != end()) {
+          std::iter_swap(left, right);
+          ++right;
+          ++left;
+        }
+        for (; left != end(); ++left) {
+          std::destroy_at(left);
+        }
 
-      _size -= last - first;
-      return begin() + idx;
+        this->_size -= last - first;
+        return begin() + idx;
+      }
     }
     unpin();
     return _dynamic_data->erase(first, last);
   }
 
   // 0(SMALL_SIZE) / 0(size); strong / strong
-  void reserve(std::size_t new_capacity) {
-    if (small_object() && size() + new_capacity > SMALL_SIZE) {
-      vector<T> vec(_static_data, size());
-      _dynamic_data._data = nullptr;
-      _dynamic_data._count = nullptr;
-      _dynamic_data = shared_data<vector<T>>(std::move(vec));
-      _dynamic_data->reserve(new_capacity);
-      _size = SMALL_SIZE + 1;
-    } else if (!small_object()) {
-      unpin();
+  constexpr void reserve(std::size_t new_capacity) {
+    if (!has_buffer()) {
+      if (new_capacity > SMALL_SIZE) {
+        change_storage(new_capacity);
+      }
+    } else {
+      unpin(new_capacity);
       _dynamic_data->reserve(new_capacity);
     }
   }
 
+  // O(SMALL_SIZE) / O(size); strong / strong
+  // New elements are left uninitialized: the caller is expected to overwrite them
+  constexpr void resize_for_overwrite(std::size_t new_size)
+    requires std::is_trivially_default_constructible_v<T>
+  {
+    if (!has_buffer() && new_size <= SMALL_SIZE) {
+      if constexpr (!PURE_COW) {
+        if (new_size < this->_size) {
+          std::destroy(begin() + new_size, end());
+        }
+        this->_size = new_size;
+      }
+    } else {
+      reserve(new_size);
+      _dynamic_data->resize_for_overwrite(new_size);
+    }
+    _profile.note_size(new_size);
+  }
+
+  // O(count) / O(count)*; strong / strong
+  // Hands `fill` a pointer to `count` uninitialized slots at the end of the vector.
+  // If `fill` returns a number, only that many leading slots are appended, otherwise all of them.
+  // Returns the number of appended elements.
+  template <typename F>
+    requires std::is_trivially_default_constructible_v<T> && std::invocable<F&, pointer>
+  constexpr std::size_t append_uninitialized(std::size_t count, F fill) {
+    pointer tail = nullptr;
+    if constexpr (PURE_COW) {
+      if (full() && count != 0) {
+        change_storage(count);
+      }
+      if (has_buffer()) {
+        tail = dynamic_tail(count);
+      }
+    } else if (small_object() && count <= SMALL_SIZE - this->_size) {
+      tail = this->_static_data.data() + this->_size;
+    } else {
+      if (small_object()) {
+        change_storage(std::max(this->_size + count, 2 * SMALL_SIZE + 1));
+      }
+      tail = dynamic_tail(count);
+    }
+
+    std::size_t written = count;
+    if constexpr (std::is_void_v<std::invoke_result_t<F&, pointer>>) {
+      fill(tail);
+    } else {
+      written = fill(tail);
+      assert(written <= count);
+    }
+
+    if (!has_buffer()) {
+      if constexpr (!PURE_COW) {
+        this->_size += written;
+      }
+      _profile.note_size(size());
+      return written;
+    }
+    _dynamic_data->commit_tail(written);
+    _profile.note_size(size());
+    return written;
+  }
+
   // 0(1) / 0(size); nothrow / strong
-  void shrink_to_fit() {
-    if (!small_object()) {
+  constexpr void shrink_to_fit() {
+    if (has_buffer()) {
       _dynamic_data->shrink_to_fit();
     }
   }
 
   // O(1) / 0(N); nothrow / nothrow
-  void clear() noexcept {
-    if (small_object()) {
-      std::destroy(begin(), end());
-      _size = 0;
+  constexpr void clear() noexcept {
+    if (!has_buffer()) {
+      if constexpr (!PURE_COW) {
+        std::destroy(begin(), end());
+        this->_size = 0;
+      }
+    } else if (_dynamic_data.use_count() > 1) {
+      // Copying a shared buffer only to destroy the copies is pointless: let the other owners keep it
+      end_dynamic();
     } else {
       unpin();
       _dynamic_data->clear();
     }
   }
 
-  friend void swap(socow_vector& lhs, socow_vector& rhs) noexcept {
+  friend constexpr void swap(socow_vector& lhs, socow_vector& rhs) noexcept {
     lhs.swap(rhs);
   }
 
   // O(1) nothrow
-  void swap(socow_vector& other) noexcept {
+  constexpr void swap(socow_vector& other) noexcept {
     using std::swap;
-    if (small_object() && other.small_object()) {
-      std::size_t i = std::min(_size, other._size);
-      std::swap_ranges(_static_data.begin(), _static_data.begin() + i, other._static_data.begin());
-      if (other._size > _size) {
-        for (; i != other._size; ++i) {
-          new (_static_data.data() + i) value_type(std::move(other._static_data[i]));
-          other._static_data[i].~value_type();
-        }
-      } else {
-        for (; i != _size; ++i) {
-          new (other._static_data.data() + i) value_type(std::move(_static_data[i]));
-          _static_data[i].~value_type();
-        }
-      }
-    } else if (!small_object() && !other.small_object()) {
+    if constexpr (PURE_COW) {
       swap(_dynamic_data, other._dynamic_data);
     } else {
-      if (small_object() && !other.small_object()) {
-        shared_data<vector<T>> buffer = other._dynamic_data;
-        other._dynamic_data.~shared_data<vector<T>>();
-        for (std::size_t i = 0; i != _size; ++i) {
-          new (other._static_data.data() + i) value_type(std::move(_static_data[i]));
-          _static_data[i].~value_type();
+      if (small_object() && other.small_object()) {
+        if (TRIVIAL_SMALL && !std::is_constant_evaluated()) {
+          alignas(T) std::byte tmp[sizeof(std::array<T, SMALL_SIZE>)];
+          copy_static_bytes(tmp, std::addressof(this->_static_data));
+          copy_static_bytes(std::addressof(this->_static_data), std::addressof(other._static_data));
+          copy_static_bytes(std::addressof(other._static_data), tmp);
+        } else {
+          swap_static(other);
         }
-        _dynamic_data._data = nullptr;
-        _dynamic_data._count = nullptr;
-        _dynamic_data = buffer;
+      } else if (!small_object() && !other.small_object()) {
+        swap(_dynamic_data, other._dynamic_data);
       } else {
-        shared_data<vector<T>> buffer = _dynamic_data;
-        _dynamic_data.~shared_data<vector<T>>();
-        for (std::size_t i = 0; i != other._size; ++i) {
-          new (_static_data.data() + i) value_type(std::move(other._static_data[i]));
-          other._static_data[i].~value_type();
+        if (small_object() && !other.small_object()) {
+          shared_data<vector<T, Storage>> buffer = std::move(other._dynamic_data);
+          other._dynamic_data.~shared_data();
+          relocate_static(*this, other);
+          std::construct_at(&_dynamic_data, std::move(buffer));
+        } else {
+          shared_data<vector<T, Storage>> buffer = std::move(_dynamic_data);
+          _dynamic_data.~shared_data();
+          relocate_static(other, *this);
+          std::construct_at(&other._dynamic_data, std::move(buffer));
         }
-        other._dynamic_data._data = nullptr;
-        other._dynamic_data._count = nullptr;
-        other._dynamic_data = buffer;
       }
+      swap(this->_size, other._size);
     }
-    swap(_size, other._size);
+    _profile.note_size(size());
+    other._profile.note_size(other.size());
   }
 
   // Element access
 
   // O(1) / O(size); nothrow / strong
-  reference operator[](std::size_t index) {
+  constexpr reference operator[](std::size_t index) {
     assert(index < size());
-    if (small_object()) {
-      return _static_data[index];
-    } else {
-      unpin();
-      return (*_dynamic_data)[index];
+    if constexpr (!PURE_COW) {
+      if (small_object()) {
+        return this->_static_data[index];
+      }
     }
+    unpin();
+    return (*_dynamic_data)[index];
   }
 
   // O(1) / O(1); nothrow / nothrow
-  const_reference operator[](std::size_t index) const noexcept {
+  constexpr const_reference operator[](std::size_t index) const noexcept {
     assert(index < size());
-    if (small_object()) {
-      return _static_data[index];
-    } else {
-      return (*_dynamic_data)[index];
+    if constexpr (!PURE_COW) {
+      if (small_object()) {
+        return this->_static_data[index];
+      }
     }
+    return std::as_const(*_dynamic_data)[index];
   }
 
   // O(1) / O(size); nothrow / strong
-  reference front() {
+  constexpr reference front() {
     return operator[](0);
   }
 
   // O(1) / O(1); nothrow / nothrow
-  const_reference front() const noexcept {
+  constexpr const_reference front() const noexcept {
     return operator[](0);
   }
 
   // O(1) / O(size); nothrow / strong
-  reference back() {
+  constexpr reference back() {
     return operator[](size() - 1);
   }
 
   // O(1) / O(1); nothrow / nothrow
-  const_reference back() const noexcept {
+  constexpr const_reference back() const noexcept {
     return operator[](size() - 1);
   }
 
   // Iterator
 
   // O(1) / O(size); nothrow / strong
-  iterator begin() {
-    if (small_object()) {
-      return _static_data.begin();
-    } else {
-      unpin();
-      return _dynamic_data->begin();
+  constexpr iterator begin() {
+    return data();
+  }
+
+  // O(1) / O(1); nothrow / nothrow
+  constexpr const_iterator begin() const noexcept {
+    return data();
+  }
+
+  // O(1) / O(size); nothrow / strong
+  constexpr iterator end() {
+    if constexpr (!PURE_COW) {
+      if (small_object()) {
+        return this->_static_data.data() + this->_size;
+      }
+    } else if (!_dynamic_data) {
+      return nullptr;
     }
+    unpin();
+    return _dynamic_data->end();
   }
 
   // O(1) / O(1); nothrow / nothrow
-  const_iterator begin() const noexcept {
-    if (small_object()) {
-      return _static_data.begin();
+  constexpr const_iterator end() const noexcept {
+    if constexpr (!PURE_COW) {
+      if (small_object()) {
+        return this->_static_data.data() + this->_size;
+      }
+    } else if (!_dynamic_data) {
+      return nullptr;
+    }
+    return std::as_const(*_dynamic_data).end();
+  }
+
+  // Memory accounting
+
+  // O(1) / O(1) if the elements don't report their usage, O(size) / O(size) otherwise; strong / strong
+  // Inline bytes are the vector object itself. Heap bytes are the element buffer with the control block that owns it,
+  // plus the heap bytes `visit(element)` returns for every element (its inline bytes are already in the buffer).
+  // Shared bytes divide everything behind a shared buffer by the number of vectors sharing it.
+  template <typename Visit = socow_element_usage>
+  constexpr socow_memory_usage memory_usage(Visit visit = {}) const {
+    socow_memory_usage result;
+    result.inline_bytes = sizeof(socow_vector);
+    std::size_t owners = 1;
+    if (has_buffer()) {
+      result.heap_bytes = capacity() * sizeof(T) + shared_data<vector<T, Storage>>::control_block_size();
+      owners = _dynamic_data.use_count();
+    }
+    double shared_bytes = static_cast<double>(result.heap_bytes);
+    if constexpr (!std::is_same_v<Visit, socow_element_usage> || socow_memory_reporting<T>) {
+      for (const T& value : *this) {
+        socow_memory_usage nested = visit(value);
+        result.heap_bytes += nested.heap_bytes;
+        shared_bytes += nested.shared_bytes;
+      }
+    }
+    result.shared_bytes = shared_bytes / static_cast<double>(owners);
+    return result;
+  }
+
+  // Buffer handoff
+
+  // O(SMALL_SIZE) / O(1) if the buffer isn't shared, O(size) otherwise; strong / strong
+  // Moves the elements out into an owning vector and leaves this one empty.
+  // A heap buffer no other vector shares is handed over as is, without touching the elements.
+  constexpr vector<T, Storage> release() {
+    vector<T, Storage> result;
+    if (!has_buffer()) {
+      if constexpr (!PURE_COW) {
+        if (this->_size != 0) {
+          result = vector<T, Storage>(std::move(this->_static_data), this->_size);
+          std::destroy(begin(), end());
+          this->_size = 0;
+        }
+      }
     } else {
-      return _dynamic_data->begin();
+      bool copied = false;
+      if constexpr (std::copy_constructible<T>) {
+        if (_dynamic_data.use_count() > 1) {
+          result = vector<T, Storage>(std::as_const(*_dynamic_data));
+          copied = true;
+        }
+      }
+      if (!copied) {
+        result = std::move(*_dynamic_data);
+      }
+      // The owner writes in place, and a cloning storage must not hand out its pages to later copies as clean
+      result.prepare_write();
+      end_dynamic();
+    }
+    _profile.note_size(0);
+    return result;
+  }
+
+  // O(SMALL_SIZE) / O(1); strong / strong
+  // Takes over the buffer of `buffer` as the shared heap buffer without moving its elements.
+  // Up to SMALL_SIZE elements are moved inline instead, as they would be stored if pushed one by one.
+  static constexpr socow_vector adopt(
+      vector<T, Storage>&& buffer,
+      socow_source_location location = socow_source_location::current()
+  ) {
+    socow_vector result(location);
+    if (buffer.size() <= SMALL_SIZE) {
+      for (T& value : buffer) {
+        result.push_back(std::move_if_noexcept(value));
+      }
+      buffer.clear();
+    } else {
+      result.begin_dynamic(shared_data<vector<T, Storage>>(std::move(buffer)));
+      result._profile.note_size(result.size());
+    }
+    return result;
+  }
+
+  // I/O
+
+#ifdef SOCOW_FD_IO
+  // O(bytes) / O(bytes)*; strong / strong
+  // Reads up to `bytes` bytes from `fd` straight into the end of the vector, stopping early at end of file.
+  // A trailing partial element is discarded. Returns the number of appended elements.
+  std::size_t append_from(int fd, std::size_t bytes)
+    requires std::is_trivially_copyable_v<T> && std::is_trivially_default_constructible_v<T>
+  {
+    return append_uninitialized(bytes / sizeof(T), [&](pointer tail) {
+      return read_fully(tail, bytes / sizeof(T), [&](void* buf, std::size_t n, std::size_t) {
+        return ::read(fd, buf, n);
+      });
+    });
+  }
+
+  // O(bytes) / O(bytes)*; strong / strong
+  // Same as above, but reads with pread starting at `offset`, leaving the file position intact
+  std::size_t append_from(int fd, std::size_t bytes, off_t offset)
+    requires std::is_trivially_copyable_v<T> && std::is_trivially_default_constructible_v<T>
+  {
+    return append_uninitialized(bytes / sizeof(T), [&](pointer tail) {
+      return read_fully(tail, bytes / sizeof(T), [&](void* buf, std::size_t n, std::size_t done) {
+        return ::pread(fd, buf, n, offset + static_cast<off_t>(done));
+      });
+    });
+  }
+#endif
+
+  // O(N) / O(N)*; basic / basic
+  // Reads `in` until end of stream. The remaining size is queried once if the stream is seekable,
+  // otherwise the buffer grows geometrically. Returns the number of appended elements.
+  // The bytes of a trailing partial element are put back into the stream, which is then left readable,
+  // unless its buffer can't take them back: they are lost then.
+  std::size_t append_from(std::istream& in)
+    requires std::is_trivially_copyable_v<T> && std::is_trivially_default_constructible_v<T>
+  {
+    std::size_t appended = 0;
+    std::size_t chunk = remaining_elements(in);
+    bool eof = false;
+    while (!eof) {
+      chunk = std::max({chunk, capacity() - size(), 4096 / sizeof(T) + 1});
+      appended += append_uninitialized(chunk, [&](pointer tail) {
+        in.read(reinterpret_cast<char*>(tail), static_cast<std::streamsize>(chunk * sizeof(T)));
+        std::size_t got = static_cast<std::size_t>(in.gcount());
+        eof = got < chunk * sizeof(T);
+        if (eof && got % sizeof(T) != 0) {
+          put_back(in, reinterpret_cast<const char*>(tail) + got / sizeof(T) * sizeof(T), got % sizeof(T));
+        }
+        return got / sizeof(T);
+      });
+      chunk = 0;
+    }
+    return appended;
+  }
+
+#ifdef SOCOW_FD_IO
+  // O(N) / O(N); strong / strong
+  // Writes the elements to `fd` without unsharing the buffer
+  void write_to(int fd) const
+    requires std::is_trivially_copyable_v<T>
+  {
+    const char* bytes = reinterpret_cast<const char*>(data());
+    std::size_t rest = size() * sizeof(T);
+    while (rest != 0) {
+      ssize_t written = ::write(fd, bytes, rest);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        socow_throw(std::system_error(errno, std::generic_category(), "write"));
+      }
+      bytes += written;
+      rest -= static_cast<std::size_t>(written);
     }
   }
+#endif
 
-  // O(1) / O(size); nothrow / strong
-  iterator end() {
-    if (small_object()) {
-      iterator begin = _static_data.begin();
-      return begin + _size;
+public:
+  // Without an inline buffer the vector is pure copy-on-write: the inline paths are compiled out,
+  // and the only thing an operation may have to check is whether an empty vector has a buffer yet
+  static constexpr bool PURE_COW = SMALL_SIZE == 0;
+
+  // Inline elements that are trivially copyable are copied, relocated and swapped as a fixed-size block of bytes.
+  // For buffers of a few cache lines that is cheaper than a loop with a data-dependent trip count.
+  static constexpr bool TRIVIAL_SMALL =
+      std::is_trivially_copyable_v<T> && sizeof(std::array<T, SMALL_SIZE>) <= 4 * SOCOW_CACHE_LINE_SIZE;
+
+  // `_size` and `_static_data` exist only with an inline buffer, hence `this->`
+  using socow_vector_fields<T, SMALL_SIZE, Storage>::_dynamic_data;
+
+  SOCOW_NO_UNIQUE_ADDRESS socow_profile_state _profile;
+
+  constexpr bool small_object() const noexcept {
+    if constexpr (PURE_COW) {
+      return false;
     } else {
-      unpin();
-      return _dynamic_data->end();
+      return this->_size <= SMALL_SIZE;
     }
   }
 
-  // O(1) / O(1); nothrow / nothrow
-  const_iterator end() const noexcept {
-    if (small_object()) {
-      const_iterator begin = _static_data.begin();
-      std::advance(begin, _size);
-      return begin;
+  // Whether the next element needs a new heap buffer
+  constexpr bool full() const noexcept {
+    if constexpr (PURE_COW) {
+      return !_dynamic_data;
     } else {
-      return _dynamic_data->end();
+      return this->_size == SMALL_SIZE;
     }
   }
 
-public:
-  std::size_t _size;
+  // Whether the elements are in a heap buffer: without an inline buffer only an empty vector may have none
+  constexpr bool has_buffer() const noexcept {
+    if constexpr (PURE_COW) {
+      return static_cast<bool>(_dynamic_data);
+    } else {
+      return !small_object();
+    }
+  }
 
-  union {
-    shared_data<vector<T>> _dynamic_data;
-    std::array<T, SMALL_SIZE> _static_data;
-  };
+  // Switches to the heap buffer `buffer` (a shared_data to copy or move from).
+  // The inline elements must already be destroyed, and without an inline buffer the empty member is reused.
+  template <typename Buffer>
+  constexpr void begin_dynamic(Buffer&& buffer) noexcept {
+    std::construct_at(&_dynamic_data, std::forward<Buffer>(buffer));
+    if constexpr (!PURE_COW) {
+      this->_size = SMALL_SIZE + 1;
+    }
+  }
 
-  bool small_object() const noexcept {
-    return _size <= SMALL_SIZE;
+  // Drops the heap buffer, leaving the vector empty
+  constexpr void end_dynamic() noexcept {
+    if constexpr (PURE_COW) {
+      _dynamic_data = shared_data<vector<T, Storage>>();
+    } else {
+      _dynamic_data.~shared_data();
+      this->_size = 0;
+      begin_static();
+    }
   }
 
-  bool full() const noexcept {
-    return _size == SMALL_SIZE;
+  // Copies the whole inline buffer, including the slots past `_size`, as raw bytes
+  static void copy_static_bytes(void* to, const void* from) noexcept {
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+// The destination may be the inactive union member, which GCC mistakes for the shared_data fields
+#pragma GCC diagnostic ignored "-Wstringop-overflow"
+#endif
+    std::memcpy(to, from, sizeof(std::array<T, SMALL_SIZE>));
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+  }
+
+  // O(SMALL_SIZE); strong
+  constexpr void copy_static(const socow_vector& other)
+    requires(!PURE_COW && std::copy_constructible<T>)
+  {
+    if (TRIVIAL_SMALL && !std::is_constant_evaluated()) {
+      copy_static_bytes(std::addressof(this->_static_data), std::addressof(other._static_data));
+    } else {
+      for (std::size_t i = 0; i != other._size; ++i) {
+        std::construct_at(this->_static_data.data() + i, other._static_data[i]);
+      }
+    }
+  }
+
+  // Moves the inline elements of `from` into the inline buffer of `to`, leaving `from` without elements.
+  // Sizes are left for the caller to fix up.
+  // O(SMALL_SIZE); nothrow
+  static constexpr void relocate_static(socow_vector& from, socow_vector& to) noexcept
+    requires(!PURE_COW)
+  {
+    if (TRIVIAL_SMALL && !std::is_constant_evaluated()) {
+      copy_static_bytes(std::addressof(to._static_data), std::addressof(from._static_data));
+    } else {
+      for (std::size_t i = 0; i != from._size; ++i) {
+        std::construct_at(to._static_data.data() + i, std::move(from._static_data[i]));
+        std::destroy_at(from._static_data.data() + i);
+      }
+    }
+  }
+
+  // O(SMALL_SIZE); nothrow
+  constexpr void swap_static(socow_vector& other) noexcept
+    requires(!PURE_COW)
+  {
+    std::size_t i = std::min(this->_size, other._size);
+    std::swap_ranges(this->_static_data.begin(), this->_static_data.begin() + i, other._static_data.begin());
+    if (other._size > this->_size) {
+      for (; i != other._size; ++i) {
+        std::construct_at(this->_static_data.data() + i, std::move(other._static_data[i]));
+        std::destroy_at(other._static_data.data() + i);
+      }
+    } else {
+      for (; i != this->_size; ++i) {
+        std::construct_at(other._static_data.data() + i, std::move(this->_static_data[i]));
+        std::destroy_at(this->_static_data.data() + i);
+      }
+    }
+  }
+
+  // Constant evaluation reads only the active member of a union, so it starts the whole inline buffer at once.
+  // Slots past `_size` then hold value-initialized elements, which is why it needs default-constructible ones.
+  constexpr void begin_static() noexcept {
+    if constexpr (!PURE_COW && std::is_default_constructible_v<T>) {
+      if (std::is_constant_evaluated()) {
+        std::construct_at(std::addressof(this->_static_data));
+      }
+    }
+  }
+
+  constexpr void attach(const socow_source_location& location) {
+    _profile.attach<socow_vector>(SMALL_SIZE, sizeof(T), location);
   }
 
   // O(SMALL_SIZE) / 0(1); strong / nothrow
-  void change_storage() {
-    vector<T> vec(_static_data, _size);
-    std::destroy(begin(), end());
-    _size = SMALL_SIZE + 1;
-    _dynamic_data._data = nullptr;
-    _dynamic_data._count = nullptr;
-    _dynamic_data = shared_data<vector<T>>(std::move(vec));
+  SOCOW_COLD constexpr void change_storage(std::size_t new_capacity) {
+    _profile.record_spill();
+    if constexpr (PURE_COW) {
+      vector<T, Storage> buffer;
+      buffer.reserve(new_capacity);
+      begin_dynamic(shared_data<vector<T, Storage>>(std::move(buffer)));
+    } else {
+      shared_data<vector<T, Storage>> buffer(
+          vector<T, Storage>(std::move(this->_static_data), this->_size, new_capacity)
+      );
+      std::destroy(begin(), end());
+      begin_dynamic(std::move(buffer));
+    }
+  }
+
+  // O(1)* / O(size); strong
+  // Unpins the heap buffer and makes room in it for `count` more elements
+  constexpr pointer dynamic_tail(std::size_t count)
+    requires std::is_trivially_default_constructible_v<T>
+  {
+    unpin(size() + count);
+    return _dynamic_data->uninitialized_tail(count);
+  }
+
+#ifdef SOCOW_FD_IO
+  // Calls `read(buffer, bytes, bytes_done)` until `count` elements are read or end of file is reached.
+  // Returns the number of whole elements read.
+  template <typename Read>
+  static std::size_t read_fully(pointer buffer, std::size_t count, Read read) {
+    char* bytes = reinterpret_cast<char*>(buffer);
+    std::size_t done = 0;
+    std::size_t total = count * sizeof(T);
+    while (done != total) {
+      ssize_t got = read(bytes + done, total - done, done);
+      if (got < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        socow_throw(std::system_error(errno, std::generic_category(), "read"));
+      }
+      if (got == 0) {
+        break;
+      }
+      done += static_cast<std::size_t>(got);
+    }
+    return done / sizeof(T);
+  }
+#endif
+
+  // The stream buffer is asked directly, since a failed istream::putback would set badbit
+  static void put_back(std::istream& in, const char* bytes, std::size_t count) {
+    using traits = std::streambuf::traits_type;
+    std::streambuf* buffer = in.rdbuf();
+    std::size_t returned = 0;
+    while (returned != count && buffer->sputbackc(bytes[count - 1 - returned]) != traits::eof()) {
+      ++returned;
+    }
+    if (returned == count) {
+      in.clear();
+      return;
+    }
+    // All or nothing: the stream never resumes in the middle of the partial element
+    for (; returned != 0; --returned) {
+      buffer->sbumpc();
+    }
+  }
+
+  static std::size_t remaining_elements(std::istream& in) {
+    std::istream::pos_type pos = in.tellg();
+    if (pos == std::istream::pos_type(-1) || !in.seekg(0, std::ios_base::end)) {
+      in.clear();
+      return 0;
+    }
+    std::istream::pos_type end = in.tellg();
+    in.seekg(pos);
+    return end > pos ? static_cast<std::size_t>(end - pos) / sizeof(T) + 1 : 0;
   }
 
   // O(1) / 0(size); nothrow / strong
-  void unpin() {
-    if (!small_object() && _dynamic_data.use_count() > 1) {
-      _dynamic_data = shared_data<vector<T>>(*_dynamic_data);
+  // Move-only elements can't be shared: such vectors are not copyable,
+  // so their heap buffer is always uniquely owned and there is nothing to unpin.
+  // A caller about to grow the buffer passes the capacity it needs, so that a shared buffer is copied only once.
+  // Without an inline buffer the callers make sure there is a heap buffer.
+  constexpr void unpin(std::size_t min_capacity = 0) {
+    if constexpr (PURE_COW) {
+      assert(_dynamic_data);
+    } else if (small_object()) {
+      return;
+    }
+    if constexpr (std::copy_constructible<T>) {
+      if (_dynamic_data.use_count() > 1) [[unlikely]] {
+        unshare(min_capacity);
+      }
+    } else {
+      assert(_dynamic_data.use_count() == 1);
+    }
+  }
+
+  // 0(size); strong
+  SOCOW_COLD constexpr void unshare(std::size_t min_capacity)
+    requires std::copy_constructible<T>
+  {
+    const vector<T, Storage>& shared = *_dynamic_data;
+    _profile.record_unpin(shared.size() * sizeof(T));
+    if (min_capacity <= shared.size()) {
+      // A plain copy lets a cloning storage share the pages
+      _dynamic_data = shared_data<vector<T, Storage>>(shared);
+    } else {
+      _dynamic_data = shared_data<vector<T, Storage>>(shared, shared.size(), min_capacity);
     }
   }
 };
+
+// Bit-packed specialization for bool
+#include "socow-bit-vector.h"
@@ -1,10 +1,18 @@
 #pragma once
 
+#include "heap-storage.h"
+#include "socow-config.h"
+
 #include <algorithm>
+#include <concepts>
 #include <cstddef>
+#include <memory>
 #include <new>
+#include <type_traits>
+#include <utility>
 
-template <typename T>
+// `Storage` provides the raw memory of the buffer, see heap-storage.h
+template <typename T, typename Storage = heap_storage>
 class vector {
 public:
   using value_type = T;
@@ -20,58 +28,64 @@ public:
 
 public:
   // O(1) nothrow
-  vector() noexcept
+  constexpr vector() noexcept
       : _capacity(0)
       , _size(0)
       , _data(nullptr) {}
 
   // O(N) strong
-  vector(const vector& other)
+  constexpr vector(const vector& other)
+    requires std::copy_constructible<T>
       : _capacity(other.size())
       , _size(other.size())
       , _data(nullptr) {
+    if constexpr (std::is_trivially_copyable_v<T> && cloning_storage<Storage>) {
+      void* clone = _storage.clone(other._storage, other.data(), sizeof(value_type) * other.capacity());
+      if (clone != nullptr) {
+        _data = static_cast<pointer>(clone);
+        _capacity = other.capacity();
+        return;
+      }
+    }
     if (_capacity > 0) {
-      auto tmp = create_tmp(other, other.capacity());
+      auto tmp = create_tmp(_storage, other, size(), capacity());
       _data = tmp;
     }
   }
 
   // O(1) strong
-  vector(vector&& other) noexcept
-      : _capacity(other.size())
+  constexpr vector(vector&& other) noexcept
+      : _capacity(other.capacity())
       , _size(other.size())
-      , _data(other.data()) {
+      , _data(other.data())
+      , _storage(std::move(other._storage)) {
     other._capacity = 0;
     other._size = 0;
     other._data = nullptr;
   }
 
   // O(N) strong
+  // Copies (or moves, if `other` is an rvalue) the first `new_size` elements of `other`
   template <typename Array>
-  vector(const Array& other, std::size_t new_capacity)
-      : _capacity(other.size())
-      , _size(other.size())
+  constexpr vector(Array&& other, std::size_t new_size, std::size_t new_capacity)
+      : _capacity(new_capacity)
+      , _size(new_size)
       , _data(nullptr) {
     if (_capacity > 0) {
-      auto tmp = create_tmp(other, new_capacity);
+      auto tmp = create_tmp(_storage, std::forward<Array>(other), new_size, new_capacity);
       _data = tmp;
     }
   }
 
   // O(N) strong
   template <typename Array>
-  vector(Array&& other, std::size_t new_size)
-      : _capacity(new_size)
-      , _size(new_size)
-      , _data(nullptr) {
-    if (_capacity > 0) {
-      auto tmp = create_tmp(std::forward<Array>(other), new_size);
-      _data = tmp;
-    }
-  }
+  constexpr vector(Array&& other, std::size_t new_size)
+      : vector(std::forward<Array>(other), new_size, new_size) {}
 
   // O(N) strong
-  vector& operator=(const vector& other) {
+  constexpr vector& operator=(const vector& other)
+    requires std::copy_constructible<T>
+  {
     if (this == &other) {
       return *this;
     }
@@ -80,7 +94,7 @@ public:
   }
 
   // O(1) strong
-  vector& operator=(vector&& other) noexcept {
+  constexpr vector& operator=(vector&& other) noexcept {
     if (this == &other) {
       return *this;
     }
@@ -89,154 +103,190 @@ public:
   }
 
   // O(N) nothrow
-  ~vector() noexcept {
-    data_clear(data(), size());
+  constexpr ~vector() noexcept {
+    data_clear(_storage, data(), size(), capacity());
   }
 
   // O(1) nothrow
-  reference operator[](size_t index) {
-    return *(_data + index);
+  constexpr reference operator[](size_t index) {
+    return *(data() + index);
   }
 
   // O(1) nothrow
-  const_reference operator[](size_t index) const {
+  constexpr const_reference operator[](size_t index) const {
     return *(_data + index);
   }
 
   // O(1) nothrow
-  pointer data() noexcept {
+  // Every non-const access to the elements goes through here, see prepare_write
+  constexpr pointer data() noexcept {
+    prepare_write();
     return _data;
   }
 
   // O(1) nothrow
-  const_pointer data() const noexcept {
+  constexpr const_pointer data() const noexcept {
     return _data;
   }
 
   // O(1) nothrow
-  size_t size() const noexcept {
+  constexpr size_t size() const noexcept {
     return _size;
   }
 
   // O(1) nothrow
-  reference front() {
+  constexpr reference front() {
     return *(data());
   }
 
   // O(1) nothrow
-  const_reference front() const {
+  constexpr const_reference front() const {
     return *(data());
   }
 
   // O(1) nothrow
-  reference back() {
+  constexpr reference back() {
     return *(data() + size() - 1);
   }
 
   // O(1) nothrow
-  const_reference back() const {
+  constexpr const_reference back() const {
     return *(data() + size() - 1);
   }
 
   // O(1)* strong
-  void push_back(const T& value) {
+  constexpr void push_back(const T& value)
+    requires std::copy_constructible<T>
+  {
     value_type v = value;
-    push_back(v);
+    push_back(std::move(v));
   }
 
   // O(1)* strong
-  void push_back(T&& value) {
-    if (_size == _capacity) {
-      auto tmp = create_tmp(std::move(*this), _capacity * 2 + 1);
-      try {
-        new (tmp + size()) value_type(std::move(value));
-      } catch (...) {
-        data_clear(tmp, size());
-        throw;
-      }
-      data_clear(data(), size());
-      _data = tmp;
-      _capacity = _capacity * 2 + 1;
+  constexpr void push_back(T&& value) {
+    if (_size != _capacity) [[likely]] {
+      std::construct_at(data() + size(), std::move(value));
       ++_size;
     } else {
-      new (data() + size()) value_type(std::move(value));
-      ++_size;
+      grow_and_push_back(std::move(value));
     }
   }
 
   // O(1) nothrow
-  void pop_back() noexcept {
-    data()[size() - 1].~value_type();
+  constexpr void pop_back() noexcept {
+    std::destroy_at(data() + size() - 1);
     --_size;
   }
 
   // O(1) nothrow
-  bool empty() const noexcept {
+  constexpr bool empty() const noexcept {
     return size() == 0;
   }
 
   // O(1) nothrow
-  size_t capacity() const noexcept {
+  constexpr size_t capacity() const noexcept {
     return _capacity;
   }
 
   // O(N) strong
-  void reserve(size_t new_capacity) {
+  constexpr void reserve(size_t new_capacity) {
     if (new_capacity > capacity()) {
       change_capacity(new_capacity);
     }
   }
 
   // O(N) strong
-  void shrink_to_fit() {
+  constexpr void shrink_to_fit() {
     if (size() < capacity()) {
       change_capacity(size());
     }
   }
 
+  // O(N) strong
+  constexpr void resize_for_overwrite(size_t new_size)
+    requires std::is_trivially_default_constructible_v<T>
+  {
+    if (new_size > capacity()) {
+      change_capacity(new_size);
+    }
+    for (size_t j = _size; j > new_size; --j) {
+      std::destroy_at(_data + j - 1);
+    }
+    _size = new_size;
+  }
+
+  // O(1)* strong
+  // Makes room for `count` more elements and returns a pointer to the first (uninitialized) of them.
+  // They become part of the vector only after `commit_tail`.
+  constexpr pointer uninitialized_tail(size_t count)
+    requires std::is_trivially_default_constructible_v<T>
+  {
+    if (count > capacity() - size()) {
+      change_capacity(std::max(size() + count, capacity() * 2 + 1));
+    }
+    return data() + size();
+  }
+
+  // O(1) nothrow
+  constexpr void commit_tail(size_t count) noexcept {
+    _size += count;
+  }
+
   // O(N) nothrow
-  void clear() noexcept {
+  constexpr void clear() noexcept {
     for (size_t j = _size; j > 0; --j) {
-      _data[j - 1].~T();
+      std::destroy_at(_data + j - 1);
     }
     _size = 0;
   }
 
   // O(1) nothrow
-  void swap(vector& other) noexcept {
+  constexpr void swap(vector& other) noexcept {
     std::swap(_capacity, other._capacity);
     std::swap(_size, other._size);
     std::swap(_data, other._data);
+    std::swap(_storage, other._storage);
+  }
+
+  // O(1) nothrow
+  // Tells a cloning storage that the elements may be modified in place, so that later copies don't map stale pages.
+  // Called by every non-const access to the elements; reads that may be concurrent must go through a const vector.
+  constexpr void prepare_write() noexcept {
+    if constexpr (cloning_storage<Storage>) {
+      _storage.prepare_write();
+    }
   }
 
   // O(1) nothrow
-  iterator begin() noexcept {
+  constexpr iterator begin() noexcept {
     return data();
   }
 
   // O(1) nothrow
-  iterator end() noexcept {
+  constexpr iterator end() noexcept {
     return data() + size();
   }
 
   // O(1) nothrow
-  const_iterator begin() const noexcept {
+  constexpr const_iterator begin() const noexcept {
     return data();
   }
 
   // O(1) nothrow
-  const_iterator end() const noexcept {
+  constexpr const_iterator end() const noexcept {
     return data() + size();
   }
 
   // O(N) strong
-  iterator insert(const_iterator pos, const T& value) {
+  constexpr iterator insert(const_iterator pos, const T& value)
+    requires std::copy_constructible<T>
+  {
     value_type v = value;
     return insert(pos, std::move(v));
   }
 
   // O(N) strong
-  iterator insert(const_iterator pos, T&& value) {
+  constexpr iterator insert(const_iterator pos, T&& value) {
     size_t idx = pos - begin();
 
     push_back(std::move(value));
@@ -250,12 +300,12 @@ public:
   }
 
   // O(N) nothrow(swap)
-  iterator erase(const_iterator pos) noexcept {
+  constexpr iterator erase(const_iterator pos) noexcept {
     return erase(pos, pos + 1);
   }
 
   // O(N) nothrow(swap)
-  iterator erase(const_iterator first, const_iterator last) noexcept {
+  constexpr iterator erase(const_iterator first, const_iterator last) noexcept {
     if (first == last) {
       return begin() + (last - begin());
     }
@@ -269,7 +319,7 @@ public:
       ++left;
     }
     for (; left != end(); ++left) {
-      left->~value_type();
+      std::destroy_at(left);
     }
 
     _size -= last - first;
@@ -277,50 +327,137 @@ public:
   }
 
 private:
+  // Buffers of trivially copyable elements can be resized by the storage without copying the elements
+  static constexpr bool reallocatable = std::is_trivially_copyable_v<T> && reallocating_storage<Storage>;
+
   size_t _capacity;
   size_t _size;
   pointer _data;
+  SOCOW_NO_UNIQUE_ADDRESS Storage _storage;
+
+  // Constant evaluation can allocate only with std::allocator, and such buffers never outlive it
+  static constexpr pointer allocate_buffer(Storage& storage, size_t capacity) {
+    if (std::is_constant_evaluated()) {
+      return std::allocator<value_type>().allocate(capacity);
+    }
+    if constexpr (reallocatable) {
+      return static_cast<pointer>(storage.allocate_relocatable(sizeof(value_type) * capacity, alignof(value_type)));
+    } else {
+      return static_cast<pointer>(storage.allocate(sizeof(value_type) * capacity, alignof(value_type)));
+    }
+  }
+
+  static constexpr void deallocate_buffer(Storage& storage, pointer memory, size_t capacity) noexcept {
+    if (std::is_constant_evaluated()) {
+      std::allocator<value_type>().deallocate(memory, capacity);
+      return;
+    }
+    if constexpr (reallocatable) {
+      storage.deallocate_relocatable(memory, sizeof(value_type) * capacity, alignof(value_type));
+    } else {
+      storage.deallocate(memory, sizeof(value_type) * capacity, alignof(value_type));
+    }
+  }
 
   // O(N) nothrow
-  static void data_clear(pointer memory, size_t idx) noexcept {
-    for (size_t j = idx; j > 0; --j) {
-      memory[j - 1].~value_type();
+  static constexpr void data_clear(Storage& storage, pointer memory, size_t idx, size_t capacity) noexcept {
+    for (pointer end = memory + idx; end != memory; --end) {
+      std::destroy_at(end - 1);
+    }
+    if (memory != nullptr) {
+      deallocate_buffer(storage, memory, capacity);
     }
-    operator delete(memory);
   }
 
   // O(N) strong
   template <typename Array>
-  static pointer create_tmp(const Array& source, size_t new_capacity) {
-    auto tmp = static_cast<pointer>(operator new(sizeof(value_type) * new_capacity));
+  static constexpr pointer create_tmp(Storage& storage, const Array& source, size_t count, size_t new_capacity) {
+    auto tmp = allocate_buffer(storage, new_capacity);
     size_t i = 0;
-    try {
-      for (auto it = source.begin(); it != source.end() && i < new_capacity; ++i, ++it) {
-        new (tmp + i) value_type(*it);
+    SOCOW_TRY {
+      for (auto it = source.begin(); i < count; ++i, ++it) {
+        std::construct_at(tmp + i, *it);
       }
-    } catch (...) {
-      data_clear(tmp, i);
-      throw;
+    }
+    SOCOW_CATCH_ALL {
+      data_clear(storage, tmp, i, new_capacity);
+      SOCOW_RETHROW;
     }
     return tmp;
   }
 
   // O(N) strong
   template <typename Array>
-  static pointer create_tmp(Array&& source, size_t new_capacity) {
-    auto tmp = static_cast<pointer>(operator new(sizeof(value_type) * new_capacity));
+    requires (!std::is_lvalue_reference_v<Array>)
+  static constexpr pointer create_tmp(Storage& storage, Array&& source, size_t count, size_t new_capacity) {
+    auto tmp = allocate_buffer(storage, new_capacity);
     size_t i = 0;
-    for (auto it = source.begin(); it != source.end() && i < new_capacity; ++i, ++it) {
-      new (tmp + i) value_type(std::move(*it));
+    for (auto it = source.begin(); i < count; ++i, ++it) {
+      std::construct_at(tmp + i, std::move(*it));
     }
     return tmp;
   }
 
   // O(N) strong
-  void change_capacity(size_t new_capacity) {
-    auto tmp = create_tmp(*this, new_capacity);
-    data_clear(data(), size());
+  // Moves the elements into a new buffer, unless a throwing move would break the strong guarantee
+  constexpr pointer relocate_tmp(Storage& storage, size_t new_capacity) {
+    if constexpr (std::is_nothrow_move_constructible_v<T> || !std::copy_constructible<T> || !SOCOW_EXCEPTIONS) {
+      return create_tmp(storage, std::move(*this), size(), new_capacity);
+    } else {
+      return create_tmp(storage, std::as_const(*this), size(), new_capacity);
+    }
+  }
+
+  // O(N) nothrow
+  constexpr void replace_buffer(Storage& storage, pointer tmp, size_t new_capacity) noexcept {
+    data_clear(_storage, data(), size(), capacity());
     _data = tmp;
     _capacity = new_capacity;
+    _storage = std::move(storage);
+  }
+
+  // O(N) strong
+  SOCOW_COLD constexpr void grow_and_push_back(T&& value) {
+    if constexpr (reallocatable) {
+      // `value` may live in the buffer that is about to move
+      value_type copy = value;
+      change_capacity(_capacity * 2 + 1);
+      std::construct_at(data() + size(), copy);
+    } else {
+      Storage storage;
+      size_t new_capacity = _capacity * 2 + 1;
+      auto tmp = relocate_tmp(storage, new_capacity);
+      SOCOW_TRY {
+        std::construct_at(tmp + size(), std::move(value));
+      }
+      SOCOW_CATCH_ALL {
+        data_clear(storage, tmp, size(), new_capacity);
+        SOCOW_RETHROW;
+      }
+      replace_buffer(storage, tmp, new_capacity);
+    }
+    ++_size;
+  }
+
+  // O(N) strong
+  SOCOW_COLD constexpr void change_capacity(size_t new_capacity) {
+    if constexpr (reallocatable) {
+      if (_data != nullptr && !std::is_constant_evaluated()) {
+        void* memory = _storage.reallocate(
+            _data,
+            sizeof(value_type) * _capacity,
+            sizeof(value_type) * new_capacity,
+            alignof(value_type)
+        );
+        if (memory != nullptr) {
+          _data = static_cast<pointer>(memory);
+          _capacity = new_capacity;
+          return;
+        }
+      }
+    }
+    Storage storage;
+    auto tmp = relocate_tmp(storage, new_capacity);
+    replace_buffer(storage, tmp, new_capacity);
   }
 };
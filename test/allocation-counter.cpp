@@ -0,0 +1,193 @@
+#include "allocation-counter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+namespace {
+
+std::atomic<std::size_t> total_allocations{0};
+std::atomic<std::size_t> total_deallocations{0};
+thread_local std::size_t paused = 0;
+
+void* allocate(std::size_t size) {
+  allocation_counter::on_allocation();
+  void* memory = std::malloc(size == 0 ? 1 : size);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void* allocate(std::size_t size, std::align_val_t alignment) {
+  allocation_counter::on_allocation();
+  std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _MSC_VER
+  void* memory = _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+  void* memory = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align);
+#endif
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void deallocate(void* memory) noexcept {
+  if (memory != nullptr) {
+    allocation_counter::on_deallocation();
+    std::free(memory);
+  }
+}
+
+// MSVC can't release _aligned_malloc blocks with free
+void deallocate(void* memory, std::align_val_t) noexcept {
+#ifdef _MSC_VER
+  if (memory != nullptr) {
+    allocation_counter::on_deallocation();
+    _aligned_free(memory);
+  }
+#else
+  deallocate(memory);
+#endif
+}
+
+} // namespace
+
+allocation_counter::allocation_counter() noexcept {
+  reset();
+}
+
+std::size_t allocation_counter::allocations() const noexcept {
+  return total_allocations.load(std::memory_order_relaxed) - old_allocations;
+}
+
+std::size_t allocation_counter::deallocations() const noexcept {
+  return total_deallocations.load(std::memory_order_relaxed) - old_deallocations;
+}
+
+void allocation_counter::reset() noexcept {
+  old_allocations = total_allocations.load(std::memory_order_relaxed);
+  old_deallocations = total_deallocations.load(std::memory_order_relaxed);
+}
+
+allocation_counter::pause::pause() noexcept {
+  ++paused;
+}
+
+allocation_counter::pause::~pause() {
+  --paused;
+}
+
+void allocation_counter::on_allocation() noexcept {
+  if (paused == 0) {
+    total_allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void allocation_counter::on_deallocation() noexcept {
+  if (paused == 0) {
+    total_deallocations.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void* operator new(std::size_t size) {
+  return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+  return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return allocate(size, alignment);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  try {
+    return allocate(size, alignment);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  try {
+    return allocate(size, alignment);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void operator delete(void* memory) noexcept {
+  deallocate(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+  deallocate(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+  deallocate(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+  deallocate(memory);
+}
+
+void operator delete(void* memory, std::align_val_t alignment) noexcept {
+  deallocate(memory, alignment);
+}
+
+void operator delete[](void* memory, std::align_val_t alignment) noexcept {
+  deallocate(memory, alignment);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept {
+  deallocate(memory, alignment);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t alignment) noexcept {
+  deallocate(memory, alignment);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+  deallocate(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+  deallocate(memory);
+}
+
+void operator delete(void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  deallocate(memory, alignment);
+}
+
+void operator delete[](void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  deallocate(memory, alignment);
+}
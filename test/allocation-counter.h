@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+// Counts calls of the global operator new / operator delete made since construction.
+// Bookkeeping of the test harness itself runs under `pause` and isn't counted.
+class allocation_counter {
+public:
+  allocation_counter() noexcept;
+
+  allocation_counter(const allocation_counter&) = delete;
+  allocation_counter& operator=(const allocation_counter&) = delete;
+
+  std::size_t allocations() const noexcept;
+  std::size_t deallocations() const noexcept;
+
+  // Restarts counting from zero
+  void reset() noexcept;
+
+  struct pause {
+    pause() noexcept;
+
+    pause(const pause&) = delete;
+    pause& operator=(const pause&) = delete;
+
+    ~pause();
+  };
+
+  // Called by the replacement operators
+  static void on_allocation() noexcept;
+  static void on_deallocation() noexcept;
+
+private:
+  std::size_t old_allocations;
+  std::size_t old_deallocations;
+};
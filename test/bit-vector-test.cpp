@@ -0,0 +1,281 @@
+#include "socow-deque.h"
+#include "socow-vector.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+template class socow_vector<bool, 0>;
+template class socow_vector<bool, 100>;
+template class socow_vector<bool>;
+
+using bits = socow_vector<bool, 100>;
+
+namespace {
+
+void require_bits(const bits& actual, const std::vector<bool>& expected) {
+  REQUIRE(actual.size() == expected.size());
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    CAPTURE(i);
+    REQUIRE(actual[i] == expected[i]);
+  }
+  REQUIRE(std::equal(actual.begin(), actual.end(), expected.begin(), expected.end()));
+  REQUIRE(actual.count() == static_cast<std::size_t>(std::count(expected.begin(), expected.end(), true)));
+  if (actual.size() % bits::WORD_BITS != 0) {
+    REQUIRE((actual.words().back() >> (actual.size() % bits::WORD_BITS)) == 0);
+  }
+}
+
+bits pattern(std::size_t size, std::size_t period) {
+  bits result;
+  for (std::size_t i = 0; i < size; ++i) {
+    result.push_back(i % period == 0);
+  }
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("Bit vector packs bits") {
+  STATIC_REQUIRE(sizeof(socow_vector<bool, 64>) == 2 * sizeof(std::size_t));
+  STATIC_REQUIRE(sizeof(socow_vector<bool>) == SOCOW_CACHE_LINE_SIZE);
+  STATIC_REQUIRE(socow_vector_small_size<bool>() == 8 * (SOCOW_CACHE_LINE_SIZE - sizeof(std::size_t)));
+  // Only socow_vector<bool> counts bits, other containers of bool keep a byte per flag
+  STATIC_REQUIRE(socow_small_size<bool>() == SOCOW_CACHE_LINE_SIZE - sizeof(std::size_t));
+  STATIC_REQUIRE(sizeof(socow_deque<bool>) == SOCOW_CACHE_LINE_SIZE);
+
+  socow_vector<bool> mask;
+  REQUIRE(mask.capacity() == socow_vector_small_size<bool>());
+  mask.resize(socow_vector_small_size<bool>(), true);
+  REQUIRE(mask.small_object());
+  REQUIRE(mask.count() == socow_vector_small_size<bool>());
+  mask.push_back(false);
+  REQUIRE_FALSE(mask.small_object());
+  REQUIRE(mask.count() == socow_vector_small_size<bool>());
+}
+
+TEST_CASE("Bit vector matches std::vector<bool>") {
+  for (unsigned seed = 0; seed < 3; ++seed) {
+    std::mt19937 rng(seed);
+    bits actual;
+    std::vector<bool> expected;
+    for (int step = 0; step < 2000; ++step) {
+      CAPTURE(seed, step);
+      switch (rng() % 8) {
+      case 0:
+      case 1: {
+        bool value = rng() % 2 != 0;
+        actual.push_back(value);
+        expected.push_back(value);
+        break;
+      }
+      case 2:
+        if (!expected.empty()) {
+          actual.pop_back();
+          expected.pop_back();
+        }
+        break;
+      case 3:
+        if (!expected.empty()) {
+          std::size_t i = rng() % expected.size();
+          actual[i].flip();
+          expected[i] = !expected[i];
+        }
+        break;
+      case 4: {
+        std::size_t new_size = rng() % 300;
+        bool value = rng() % 2 != 0;
+        actual.resize(new_size, value);
+        expected.resize(new_size, value);
+        break;
+      }
+      case 5: {
+        bits copy = actual;
+        copy.flip();
+        actual.flip();
+        expected.flip();
+        REQUIRE(copy == actual);
+        break;
+      }
+      case 6: {
+        std::size_t i = rng() % (expected.size() + 1);
+        bool value = rng() % 2 != 0;
+        REQUIRE(actual.insert(actual.begin() + i, value) - actual.begin() == i);
+        expected.insert(expected.begin() + i, value);
+        break;
+      }
+      case 7: {
+        std::size_t first = rng() % (expected.size() + 1);
+        std::size_t last = first + rng() % (expected.size() - first + 1);
+        REQUIRE(actual.erase(actual.begin() + first, actual.begin() + last) - actual.begin() == first);
+        expected.erase(expected.begin() + first, expected.begin() + last);
+        break;
+      }
+      }
+      require_bits(actual, expected);
+    }
+  }
+}
+
+TEST_CASE("Bit vector copy-on-write") {
+  bits a = pattern(1000, 3);
+  bits b = a;
+  REQUIRE(a.words().data() == b.words().data());
+  REQUIRE(a == b);
+
+  b[0] = false;
+  REQUIRE(a.words().data() != b.words().data());
+  REQUIRE(a[0]);
+  REQUIRE_FALSE(b[0]);
+  REQUIRE(a.count() == b.count() + 1);
+
+  bits c = std::move(b);
+  REQUIRE(b.empty());
+  REQUIRE(c.size() == 1000);
+
+  bits d = pattern(10, 2);
+  d.swap(c);
+  REQUIRE(d.size() == 1000);
+  REQUIRE(c.size() == 10);
+  REQUIRE(c.count() == 5);
+  REQUIRE_FALSE(d[0]);
+  REQUIRE(d[3]);
+
+  bits shared = a;
+  a.clear();
+  REQUIRE(a.empty());
+  REQUIRE(shared.size() == 1000);
+}
+
+TEST_CASE("Bit vector insert and erase unshare the buffer") {
+  bits a = pattern(1000, 3);
+  bits b = a;
+  b.insert(b.begin() + 1, true);
+  b.erase(b.begin() + 500, b.begin() + 700);
+  REQUIRE(a == pattern(1000, 3));
+
+  std::vector<bool> expected;
+  for (std::size_t i = 0; i < 1000; ++i) {
+    expected.push_back(i % 3 == 0);
+  }
+  expected.insert(expected.begin() + 1, true);
+  expected.erase(expected.begin() + 500, expected.begin() + 700);
+  require_bits(b, expected);
+}
+
+TEST_CASE("Bit vector memory usage") {
+  bits small = pattern(50, 2);
+  REQUIRE(small.memory_usage().inline_bytes == sizeof(bits));
+  REQUIRE(small.memory_usage().heap_bytes == 0);
+
+  bits a = pattern(1000, 2);
+  std::size_t heap = a.memory_usage().heap_bytes;
+  REQUIRE(heap >= 1000 / 8);
+  bits b = a;
+  REQUIRE(a.memory_usage().heap_bytes == heap);
+  REQUIRE(a.memory_usage().shared_bytes == static_cast<double>(heap) / 2);
+}
+
+TEST_CASE("Bit vector release and adopt") {
+  bits a = pattern(1000, 3);
+  const std::uint64_t* words = a.words().data();
+  socow_bit_buffer<heap_storage> buffer = a.release();
+  REQUIRE(a.empty());
+  REQUIRE(buffer.size == 1000);
+  REQUIRE(std::as_const(buffer.words).data() == words);
+
+  bits b = bits::adopt(std::move(buffer));
+  REQUIRE(b.words().data() == words);
+  REQUIRE(b == pattern(1000, 3));
+
+  // A shared buffer is copied, a small vector is copied out of its inline words
+  bits c = b;
+  socow_bit_buffer<heap_storage> copied = c.release();
+  REQUIRE(std::as_const(copied.words).data() != words);
+  REQUIRE(b == pattern(1000, 3));
+  bits small = bits::adopt(pattern(50, 2).release());
+  REQUIRE(small.small_object());
+  REQUIRE(small == pattern(50, 2));
+}
+
+TEST_CASE("Bit vector find first") {
+  bits a(500, false);
+  REQUIRE(a.find_first() == 500);
+  a[7] = true;
+  a[64] = true;
+  a[499] = true;
+  REQUIRE(a.find_first() == 7);
+  REQUIRE(a.find_first(7) == 7);
+  REQUIRE(a.find_first(8) == 64);
+  REQUIRE(a.find_first(65) == 499);
+  REQUIRE(a.find_first(500) == 500);
+
+  std::vector<std::size_t> set;
+  for (std::size_t i = a.find_first(); i != a.size(); i = a.find_first(i + 1)) {
+    set.push_back(i);
+  }
+  REQUIRE(set == std::vector<std::size_t>{7, 64, 499});
+}
+
+TEST_CASE("Bit vector bitwise operations") {
+  for (std::size_t size : {50, 200}) {
+    CAPTURE(size);
+    bits twos = pattern(size, 2);
+    bits threes = pattern(size, 3);
+    bits both = twos & threes;
+    bits either = twos | threes;
+    bits one = twos ^ threes;
+    for (std::size_t i = 0; i < size; ++i) {
+      CAPTURE(i);
+      REQUIRE(both[i] == (i % 6 == 0));
+      REQUIRE(either[i] == (i % 2 == 0 || i % 3 == 0));
+      REQUIRE(one[i] == ((i % 2 == 0) != (i % 3 == 0)));
+    }
+    REQUIRE(twos == pattern(size, 2));
+
+    // Combining with a vector sharing the buffer unshares only the target
+    bits copy = twos;
+    copy ^= twos;
+    REQUIRE(copy.count() == 0);
+    REQUIRE(twos.count() == (size + 1) / 2);
+    copy |= copy;
+    REQUIRE(copy.count() == 0);
+  }
+}
+
+TEST_CASE("Bit vector without inline bits") {
+  socow_vector<bool, 0> a;
+  REQUIRE(a.capacity() == 0);
+  a.push_back(true);
+  a.push_back(false);
+  socow_vector<bool, 0> b = a;
+  b.back() = true;
+  REQUIRE(a.count() == 1);
+  REQUIRE(b.count() == 2);
+  std::vector<bool> values(std::as_const(b).begin(), std::as_const(b).end());
+  REQUIRE(values == std::vector<bool>{true, true});
+}
+
+#ifndef SOCOW_PROFILE
+TEST_CASE("Constexpr bit vector") {
+  constexpr auto count_primes = [] {
+    socow_vector<bool, 128> sieve(100, true);
+    sieve[0] = false;
+    sieve[1] = false;
+    for (std::size_t i = 2; i * i < sieve.size(); ++i) {
+      if (sieve[i]) {
+        for (std::size_t j = i * i; j < sieve.size(); j += i) {
+          sieve[j] = false;
+        }
+      }
+    }
+    return sieve.count();
+  };
+  STATIC_REQUIRE(count_primes() == 25);
+}
+#endif
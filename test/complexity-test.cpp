@@ -0,0 +1,199 @@
+#include "allocation-counter.h"
+#include "socow-vector.h"
+#include "test-utils.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <utility>
+
+// Exact numbers of allocations, copies and moves behind the complexity comments of `socow_vector`.
+// Counts are read into locals before checking them, since Catch2 allocates itself.
+// The profiler allocates its own bookkeeping, so the counts only hold without it.
+#ifndef SOCOW_PROFILE
+
+namespace {
+
+constexpr std::size_t SMALL = 3;
+constexpr std::size_t LARGE = 10;
+
+using vector_type = socow_vector<element, SMALL>;
+
+vector_type make(std::size_t size) {
+  vector_type result;
+  result.reserve(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    result.push_back(static_cast<int>(i));
+  }
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("Small push back doesn't allocate") {
+  element::no_new_intances_guard ig;
+
+  vector_type a;
+  allocation_counter allocations;
+  element::operation_counter operations;
+  for (std::size_t i = 0; i < SMALL; ++i) {
+    a.push_back(static_cast<int>(i));
+  }
+  std::size_t allocated = allocations.allocations();
+  std::size_t moves = operations.moves();
+
+  REQUIRE(allocated == 0);
+  REQUIRE(moves == SMALL);
+}
+
+TEST_CASE("Spill allocates the buffer and its owner once") {
+  element::no_new_intances_guard ig;
+
+  vector_type a = make(SMALL);
+  allocation_counter allocations;
+  element::operation_counter operations;
+  a.push_back(42);
+  std::size_t allocated = allocations.allocations();
+  std::size_t copies = operations.copies();
+
+  REQUIRE(allocated == 2);
+  REQUIRE(copies == 0);
+}
+
+TEST_CASE("Copy of a small vector copies its elements") {
+  element::no_new_intances_guard ig;
+
+  vector_type a = make(SMALL);
+  allocation_counter allocations;
+  element::operation_counter operations;
+  vector_type b = a;
+  std::size_t allocated = allocations.allocations();
+  std::size_t copies = operations.copies();
+
+  REQUIRE(allocated == 0);
+  REQUIRE(copies == SMALL);
+}
+
+TEST_CASE("Copy of a large vector is O(1)") {
+  element::no_new_intances_guard ig;
+
+  vector_type a = make(LARGE);
+  allocation_counter allocations;
+  element::operation_counter operations;
+  vector_type b = a;
+  vector_type c;
+  c = a;
+  std::size_t allocated = allocations.allocations();
+  std::size_t copies = operations.copies();
+
+  REQUIRE(allocated == 0);
+  REQUIRE(copies == 0);
+  REQUIRE(std::as_const(b).data() == std::as_const(a).data());
+  REQUIRE(std::as_const(c).data() == std::as_const(a).data());
+}
+
+TEST_CASE("Move and swap of large vectors are O(1)") {
+  element::no_new_intances_guard ig;
+
+  vector_type a = make(LARGE);
+  vector_type b = make(LARGE + 1);
+  allocation_counter allocations;
+  element::operation_counter operations;
+  vector_type c = std::move(a);
+  c.swap(b);
+  a = std::move(b);
+  std::size_t allocated = allocations.allocations();
+  std::size_t copies = operations.copies();
+  std::size_t moves = operations.moves();
+
+  REQUIRE(allocated == 0);
+  REQUIRE(copies == 0);
+  REQUIRE(moves == 0);
+}
+
+TEST_CASE("Unsharing copies the elements once") {
+  element::no_new_intances_guard ig;
+
+  vector_type a = make(LARGE);
+  vector_type b = a;
+  allocation_counter allocations;
+  element::operation_counter operations;
+  b[0] = 42;
+  b[1] = 43;
+  std::size_t allocated = allocations.allocations();
+  std::size_t copies = operations.copies();
+
+  REQUIRE(allocated == 2);
+  // Both assignments are moves of temporaries
+  REQUIRE(copies == LARGE);
+  REQUIRE(a[0] == 0);
+}
+
+TEST_CASE("Unique large vector is modified in place") {
+  element::no_new_intances_guard ig;
+
+  vector_type a = make(LARGE);
+  allocation_counter allocations;
+  element::operation_counter operations;
+  a[0] = 42;
+  a.pop_back();
+  a.push_back(43);
+  std::size_t allocated = allocations.allocations();
+  std::size_t copies = operations.copies();
+
+  REQUIRE(allocated == 0);
+  REQUIRE(copies == 0);
+}
+
+TEST_CASE("Destruction of a shared buffer frees it once") {
+  element::no_new_intances_guard ig;
+
+  allocation_counter allocations;
+  {
+    vector_type a = make(LARGE);
+    vector_type b = a;
+    vector_type c = b;
+  }
+  std::size_t allocated = allocations.allocations();
+  std::size_t deallocated = allocations.deallocations();
+
+  REQUIRE(allocated == 2);
+  REQUIRE(deallocated == 2);
+}
+
+// Buffers of trivially copyable elements come from operator new as well, unless the storage reallocates them
+TEST_CASE("Trivially copyable elements are allocated the same way") {
+  allocation_counter allocations;
+  {
+    socow_vector<int, SMALL> a;
+    a.reserve(LARGE);
+    for (std::size_t i = 0; i < LARGE; ++i) {
+      a.push_back(static_cast<int>(i));
+    }
+    socow_vector<int, SMALL> b = a;
+    b[0] = 42;
+  }
+  std::size_t allocated = allocations.allocations();
+  std::size_t deallocated = allocations.deallocations();
+
+  REQUIRE(allocated == 4);
+  REQUIRE(deallocated == 4);
+}
+
+// Only the control block comes from operator new, the buffer is malloc'ed and grown with realloc
+TEST_CASE("Reallocating storage bypasses operator new") {
+  allocation_counter allocations;
+  {
+    socow_vector<int, SMALL, realloc_heap_storage> a;
+    for (std::size_t i = 0; i < 100 * LARGE; ++i) {
+      a.push_back(static_cast<int>(i));
+    }
+  }
+  std::size_t allocated = allocations.allocations();
+  std::size_t deallocated = allocations.deallocations();
+
+  REQUIRE(allocated == 1);
+  REQUIRE(deallocated == 1);
+}
+
+#endif
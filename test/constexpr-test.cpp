@@ -0,0 +1,152 @@
+#include "socow-vector.h"
+#include "vector.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <utility>
+
+// Constant evaluation runs with the no-op profiling state only
+#ifndef SOCOW_PROFILE
+
+namespace {
+
+// Literal type with a non-trivial copy, so that the elements go through the generic paths
+struct counted {
+  constexpr counted() = default;
+
+  constexpr explicit counted(int v)
+      : value(v) {}
+
+  constexpr counted(const counted& other)
+      : value(other.value)
+      , copies(other.copies + 1) {}
+
+  constexpr counted& operator=(const counted& other) {
+    value = other.value;
+    copies = other.copies + 1;
+    return *this;
+  }
+
+  int value = 0;
+  int copies = 0;
+};
+
+constexpr int vector_sum(int count) {
+  vector<int> v;
+  for (int i = 0; i < count; ++i) {
+    v.push_back(i);
+  }
+  v.insert(v.begin(), 100);
+  v.erase(v.begin() + 1);
+  v.pop_back();
+  vector<int> copy = v;
+  copy.reserve(4 * copy.capacity());
+  copy.shrink_to_fit();
+  int sum = 0;
+  for (int x : copy) {
+    sum += x;
+  }
+  return sum + static_cast<int>(copy.size());
+}
+
+constexpr int vector_of_counted() {
+  vector<counted> v;
+  for (int i = 0; i < 5; ++i) {
+    v.push_back(counted(i));
+  }
+  vector<counted> copy = v;
+  copy.clear();
+  copy.push_back(v.back());
+  return copy.front().value + copy.front().copies;
+}
+
+template <std::size_t N>
+constexpr socow_vector<int, N> squares(int count) {
+  socow_vector<int, N> result;
+  for (int i = 0; i < count; ++i) {
+    result.push_back(i * i);
+  }
+  return result;
+}
+
+constexpr int socow_operations() {
+  socow_vector<int, 8> a = squares<8>(5);
+  socow_vector<int, 8> b = a;
+  b.insert(b.begin(), -1);
+  b.erase(b.end() - 2);
+  a.swap(b);
+  socow_vector<int, 8> c = std::move(b);
+  c = a;
+  c.pop_back();
+  return a.size() == 5 && b.empty() && c.size() == 4 && a.front() == -1 && a.back() == 16 && c.back() == 4;
+}
+
+constexpr int socow_of_counted() {
+  socow_vector<counted, 4> a;
+  a.push_back(counted(7));
+  a.push_back(counted(8));
+  socow_vector<counted, 4> b = a;
+  socow_vector<counted, 4> c;
+  c.push_back(counted(9));
+  c.swap(b);
+  return c[1].value + b[0].value;
+}
+
+constexpr std::size_t released_size() {
+  socow_vector<int, 8> a = squares<8>(6);
+  vector<int> released = a.release();
+  return released.size() + a.size();
+}
+
+// Heap buffers are shared and unshared during the evaluation, but must be gone by its end
+constexpr int socow_heap_operations() {
+  socow_vector<int, 2> a = squares<2>(10);
+  socow_vector<int, 2> b = a;
+  bool shared = std::as_const(a).data() == std::as_const(b).data() && a._dynamic_data.use_count() == 2;
+  b[0] = -1;
+  bool unshared = std::as_const(a).data() != std::as_const(b).data() && a._dynamic_data.use_count() == 1;
+  b.push_back(100);
+  b.erase(b.begin() + 1, b.end() - 1);
+  socow_vector<int, 2> c = std::move(a);
+  c.swap(b);
+  vector<int> released = b.release();
+  return shared && unshared && a.empty() && b.empty() && c.size() == 2 && c[0] == -1 && c[1] == 100 &&
+         released.size() == 10 && released[9] == 81;
+}
+
+constexpr int socow_heap_of_counted() {
+  socow_vector<counted, 0> a;
+  for (int i = 0; i < 3; ++i) {
+    a.push_back(counted(i));
+  }
+  socow_vector<counted, 0> b = a;
+  b.pop_back();
+  return static_cast<int>(a.size() + b.size()) + a[2].value;
+}
+
+// Built at compile time and emitted as read-only data
+constexpr socow_vector<int, 16> SQUARES = squares<16>(10);
+
+} // namespace
+
+TEST_CASE("Constexpr vector") {
+  STATIC_REQUIRE(vector_sum(3) == 100 + 1 + 2);
+  STATIC_REQUIRE(vector_sum(10) == 100 + (1 + 2 + 3 + 4 + 5 + 6 + 7 + 8) + 9);
+  STATIC_REQUIRE(vector_of_counted() == 4 + 3);
+}
+
+TEST_CASE("Constexpr socow_vector") {
+  STATIC_REQUIRE(socow_operations());
+  STATIC_REQUIRE(socow_of_counted() == 8 + 9);
+  STATIC_REQUIRE(released_size() == 6);
+
+  STATIC_REQUIRE(socow_heap_operations());
+  STATIC_REQUIRE(socow_heap_of_counted() == 3 + 2 + 2);
+
+  STATIC_REQUIRE(SQUARES.size() == 10);
+  STATIC_REQUIRE(SQUARES[9] == 81);
+  REQUIRE(SQUARES.back() == 81);
+}
+
+#endif
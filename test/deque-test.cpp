@@ -0,0 +1,208 @@
+#include "element.h"
+#include "socow-deque.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <utility>
+
+template class socow_deque<int, 3>;
+template class socow_deque<int, 0>;
+template class socow_deque<element, 3>;
+template class socow_deque<std::unique_ptr<int>, 3>;
+
+namespace {
+
+template <std::size_t SMALL_SIZE>
+void require_equal(const socow_deque<element, SMALL_SIZE>& actual, const std::deque<int>& expected) {
+  REQUIRE(actual.size() == expected.size());
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    CAPTURE(i);
+    REQUIRE(actual[i] == expected[i]);
+  }
+  REQUIRE(std::distance(actual.begin(), actual.end()) == static_cast<std::ptrdiff_t>(expected.size()));
+}
+
+// Random operations at both ends and in the middle, checked against std::deque
+template <std::size_t SMALL_SIZE>
+void run_against_model(unsigned seed) {
+  element::no_new_intances_guard ig;
+
+  std::mt19937 random(seed);
+  socow_deque<element, SMALL_SIZE> actual;
+  std::deque<int> expected;
+  for (int step = 0; step < 500; ++step) {
+    CAPTURE(step);
+    int value = static_cast<int>(random() % 1000);
+    std::size_t index = expected.empty() ? 0 : random() % expected.size();
+    switch (random() % 8) {
+    case 0:
+    case 1:
+      actual.push_back(value);
+      expected.push_back(value);
+      break;
+    case 2:
+    case 3:
+      actual.push_front(value);
+      expected.push_front(value);
+      break;
+    case 4:
+      if (!expected.empty()) {
+        actual.pop_back();
+        expected.pop_back();
+      }
+      break;
+    case 5:
+      if (!expected.empty()) {
+        actual.pop_front();
+        expected.pop_front();
+      }
+      break;
+    case 6: {
+      auto it = actual.insert(std::as_const(actual).begin() + index, value);
+      REQUIRE(*it == value);
+      expected.insert(expected.begin() + index, value);
+      break;
+    }
+    default:
+      if (!expected.empty()) {
+        std::size_t count = std::min<std::size_t>(random() % 3, expected.size() - index);
+        auto it = actual.erase(std::as_const(actual).begin() + index, std::as_const(actual).begin() + index + count);
+        REQUIRE(it - actual.begin() == static_cast<std::ptrdiff_t>(index));
+        expected.erase(expected.begin() + index, expected.begin() + index + count);
+      }
+    }
+    if (step % 97 == 0) {
+      // Copies must not see later modifications
+      socow_deque<element, SMALL_SIZE> copy = actual;
+      std::deque<int> copy_expected = expected;
+      actual.push_front(-1);
+      expected.push_front(-1);
+      require_equal(copy, copy_expected);
+    }
+    require_equal(actual, expected);
+  }
+}
+
+} // namespace
+
+TEST_CASE("Deque against model") {
+  for (unsigned seed = 0; seed < 3; ++seed) {
+    CAPTURE(seed);
+    run_against_model<3>(seed);
+    run_against_model<0>(seed);
+  }
+}
+
+TEST_CASE("Deque small object") {
+  socow_deque<int, 3> d;
+  d.push_back(2);
+  d.push_front(1);
+  d.push_back(3);
+  REQUIRE(d.capacity() == 3);
+  d.pop_front();
+  d.push_back(4);
+  REQUIRE(d.capacity() == 3);
+  REQUIRE(d.front() == 2);
+  REQUIRE(d.back() == 4);
+
+  d.push_front(0);
+  REQUIRE(d.capacity() > 3);
+  REQUIRE(d == socow_deque<int, 3>(d));
+}
+
+TEST_CASE("Deque copy on write") {
+  socow_deque<int, 3> a;
+  for (int i = 0; i < 20; ++i) {
+    a.push_back(i);
+  }
+  socow_deque<int, 3> b = a;
+  REQUIRE(&std::as_const(b)[0] == &std::as_const(a)[0]);
+
+  b.pop_front();
+  REQUIRE(&std::as_const(b)[0] != &std::as_const(a)[1]);
+  REQUIRE(a.size() == 20);
+  REQUIRE(b.size() == 19);
+  REQUIRE(a.front() == 0);
+  REQUIRE(b.front() == 1);
+
+  socow_memory_usage usage = a.memory_usage();
+  REQUIRE(usage.heap_bytes >= 20 * sizeof(int));
+}
+
+TEST_CASE("Deque front operations move nothing") {
+  socow_deque<element, 3> d;
+  for (int i = 0; i < 100; ++i) {
+    d.push_back(i);
+  }
+  d.reserve(200);
+
+  element::operation_counter operations;
+  for (int i = 0; i < 50; ++i) {
+    d.pop_front();
+    d.erase(std::as_const(d).begin());
+    d.push_back(i);
+  }
+  REQUIRE(operations.copies() == 0);
+  REQUIRE(operations.moves() == 50);
+  REQUIRE(d.size() == 50);
+  REQUIRE(d.front() == 0);
+}
+
+TEST_CASE("Deque insert and erase move the shorter side") {
+  socow_deque<element, 3> d;
+  for (int i = 0; i < 100; ++i) {
+    d.push_back(i);
+  }
+  d.reserve(200);
+
+  element::operation_counter operations;
+  d.insert(std::as_const(d).begin() + 2, 1000);
+  d.erase(std::as_const(d).end() - 3);
+  REQUIRE(operations.moves() < 10);
+  REQUIRE(d[2] == 1000);
+  REQUIRE(d[3] == 2);
+  REQUIRE(d[97] == 96);
+  REQUIRE(d[98] == 98);
+}
+
+TEST_CASE("Deque swap") {
+  element::no_new_intances_guard ig;
+
+  socow_deque<element, 3> small;
+  small.push_back(1);
+  small.push_front(0);
+  socow_deque<element, 3> large;
+  for (int i = 0; i < 10; ++i) {
+    large.push_front(i);
+  }
+
+  swap(small, large);
+  REQUIRE(small.size() == 10);
+  REQUIRE(small.front() == 9);
+  REQUIRE(large.size() == 2);
+  REQUIRE(large.front() == 0);
+  REQUIRE(large.back() == 1);
+
+  socow_deque<element, 3> moved = std::move(small);
+  REQUIRE(small.empty());
+  REQUIRE(moved.size() == 10);
+  moved.clear();
+  REQUIRE(moved.empty());
+}
+
+TEST_CASE("Deque of move-only elements") {
+  socow_deque<std::unique_ptr<int>, 3> d;
+  for (int i = 0; i < 10; ++i) {
+    d.push_front(std::make_unique<int>(i));
+  }
+  d.insert(std::as_const(d).begin() + 5, std::make_unique<int>(100));
+  REQUIRE(*d[5] == 100);
+  REQUIRE(*d.front() == 9);
+  d.pop_back();
+  REQUIRE(*d.back() == 1);
+}
@@ -1,5 +1,7 @@
 #include "element.h"
 
+#include "allocation-counter.h"
+
 #include <catch2/catch_test_macros.hpp>
 
 #include <utility>
@@ -14,6 +16,7 @@ element::element(const element& other)
   other.assert_exists();
   add_instance();
   value = other.value;
+  ++total_copies;
 }
 
 element::element(element&& other) noexcept
@@ -21,6 +24,7 @@ element::element(element&& other) noexcept
   other.assert_exists();
   add_instance();
   value = std::exchange(other.value, -1);
+  ++total_moves;
 }
 
 element::~element() {
@@ -32,6 +36,7 @@ element& element::operator=(const element& other) {
   other.assert_exists();
 
   value = other.value;
+  ++total_copies;
   return *this;
 }
 
@@ -40,6 +45,7 @@ element& element::operator=(element&& other) noexcept {
   other.assert_exists();
 
   value = std::exchange(other.value, -1);
+  ++total_moves;
   return *this;
 }
 
@@ -61,6 +67,7 @@ std::ostream& operator<<(std::ostream& out, const element& e) {
 }
 
 void element::add_instance() {
+  allocation_counter::pause pause;
   auto p = instances.insert(this);
   if (!p.second) {
     // clang-format off
@@ -74,6 +81,7 @@ void element::add_instance() {
 }
 
 void element::delete_instance() {
+  allocation_counter::pause pause;
   std::size_t erased = instances.erase(this);
   if (erased != 1) {
     FAIL("Attempt of destroying non-existing object at address " << static_cast<void*>(this));
@@ -88,9 +96,10 @@ void element::assert_exists() const {
 }
 
 element::no_new_intances_guard::no_new_intances_guard()
-    : old_instances(instances) {}
+    : old_instances((allocation_counter::pause(), instances)) {}
 
 element::no_new_intances_guard::~no_new_intances_guard() noexcept(false) {
+  allocation_counter::pause pause;
   if (std::uncaught_exceptions() == 0) {
     bool no_new_instances = check_no_new_instances();
     instances = old_instances;
@@ -103,3 +112,15 @@ element::no_new_intances_guard::~no_new_intances_guard() noexcept(false) {
 bool element::no_new_intances_guard::check_no_new_instances() const noexcept {
   return old_instances == instances;
 }
+
+element::operation_counter::operation_counter() noexcept
+    : old_copies(total_copies)
+    , old_moves(total_moves) {}
+
+std::size_t element::operation_counter::copies() const noexcept {
+  return total_copies - old_copies;
+}
+
+std::size_t element::operation_counter::moves() const noexcept {
+  return total_moves - old_moves;
+}
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <cstddef>
 #include <ostream>
 #include <set>
 
 struct element {
   struct no_new_intances_guard;
+  struct operation_counter;
 
   element() = delete;
   element(int data);
@@ -29,6 +31,8 @@ private:
   int value;
 
   inline static std::set<const element*> instances;
+  inline static std::size_t total_copies = 0;
+  inline static std::size_t total_moves = 0;
 };
 
 struct element::no_new_intances_guard {
@@ -44,3 +48,18 @@ struct element::no_new_intances_guard {
 private:
   std::set<const element*> old_instances;
 };
+
+// Counts copies (constructions and assignments) and moves of elements made since construction
+struct element::operation_counter {
+  operation_counter() noexcept;
+
+  operation_counter(const operation_counter&) = delete;
+  operation_counter& operator=(const operation_counter&) = delete;
+
+  std::size_t copies() const noexcept;
+  std::size_t moves() const noexcept;
+
+private:
+  std::size_t old_copies;
+  std::size_t old_moves;
+};
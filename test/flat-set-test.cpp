@@ -0,0 +1,177 @@
+#include "socow-flat-map.h"
+#include "socow-flat-set.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+template class socow_sorted_vector<int, std::identity, 4, std::less<int>>;
+template class socow_flat_set<int, 4>;
+template class socow_sorted_vector<std::pair<int, std::string>, socow_pair_first, 2, std::less<int>>;
+template class socow_flat_map<int, std::string, 2>;
+
+TEST_CASE("Branchless lower bound") {
+  std::vector<int> values;
+  for (int size = 0; size <= 40; ++size) {
+    CAPTURE(size);
+    for (int key = -1; key <= 2 * size + 1; ++key) {
+      CAPTURE(key);
+      const int* result = socow_lower_bound(values.data(), values.size(), key, std::identity(), std::less<int>());
+      REQUIRE(result == std::to_address(std::lower_bound(values.begin(), values.end(), key)));
+    }
+    values.push_back(2 * size);
+  }
+}
+
+TEST_CASE("Flat set insert and erase") {
+  socow_flat_set<int, 3> s;
+  REQUIRE(s.insert(5).second);
+  REQUIRE(s.insert(1).second);
+  REQUIRE(s.insert(3).second);
+  REQUIRE_FALSE(s.insert(3).second);
+  REQUIRE(s.size() == 3);
+  REQUIRE(s.capacity() == 3);
+
+  REQUIRE(s.insert(4).second);
+  REQUIRE(s.insert(2).second);
+  REQUIRE(s.size() == 5);
+  for (std::size_t i = 0; i < s.size(); ++i) {
+    REQUIRE(s[i] == static_cast<int>(i + 1));
+  }
+
+  REQUIRE(s.contains(4));
+  REQUIRE_FALSE(s.contains(6));
+  REQUIRE(s.find(6) == s.end());
+  REQUIRE(*s.lower_bound(0) == 1);
+  REQUIRE(*s.upper_bound(2) == 3);
+  REQUIRE(s.upper_bound(5) == s.end());
+
+  REQUIRE(s.erase(3) == 1);
+  REQUIRE(s.erase(3) == 0);
+  REQUIRE(*s.erase(s.begin()) == 2);
+  REQUIRE(s.size() == 3);
+}
+
+TEST_CASE("Flat set copies share a buffer") {
+  socow_flat_set<int, 4> a = {9, 7, 5, 3, 1, 8, 6, 4, 2, 0};
+  socow_flat_set<int, 4> b = a;
+  REQUIRE(b.begin() == a.begin());
+
+  b.erase(0);
+  b.insert(10);
+  REQUIRE(b.begin() != a.begin());
+  REQUIRE(a.size() == 10);
+  REQUIRE(*a.begin() == 0);
+  REQUIRE(a.contains(9));
+  REQUIRE_FALSE(a.contains(10));
+  REQUIRE(b.contains(10));
+  REQUIRE_FALSE(b.contains(0));
+
+  a.insert(0);
+  REQUIRE(a.size() == 10);
+}
+
+TEST_CASE("Flat set insert range") {
+  socow_flat_set<std::string, 3> a;
+  std::vector<std::string> first = {"6", "2", "4", "2", "8"};
+  a.insert_range(first);
+  REQUIRE(a.size() == 4);
+
+  socow_flat_set<std::string, 3> b = a;
+  const std::string* shared = b.begin();
+  std::vector<std::string> second = {"9", "1", "4", "5", "1", "7"};
+  b.insert_range(std::move(second));
+
+  REQUIRE(a.begin() == shared);
+  REQUIRE(a.size() == 4);
+
+  std::vector<std::string> expected = {"1", "2", "4", "5", "6", "7", "8", "9"};
+  REQUIRE(b.size() == expected.size());
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    CAPTURE(i);
+    REQUIRE(b[i] == expected[i]);
+  }
+
+  b.insert_range(std::vector<std::string>());
+  REQUIRE(b.size() == expected.size());
+}
+
+TEST_CASE("Flat set of move-only values") {
+  auto less = [](const std::unique_ptr<int>& lhs, const std::unique_ptr<int>& rhs) { return *lhs < *rhs; };
+  socow_flat_set<std::unique_ptr<int>, 2, decltype(less)> s(less);
+  s.insert(std::make_unique<int>(3));
+
+  std::vector<std::unique_ptr<int>> values;
+  for (int value : {4, 1, 3, 2}) {
+    values.push_back(std::make_unique<int>(value));
+  }
+  s.insert_range(std::move(values));
+
+  REQUIRE(s.size() == 4);
+  for (std::size_t i = 0; i < s.size(); ++i) {
+    REQUIRE(*s[i] == static_cast<int>(i + 1));
+  }
+}
+
+TEST_CASE("Flat map") {
+  socow_flat_map<int, std::string, 2> m;
+  m[3] = "three";
+  m[1] = "one";
+  REQUIRE(m.insert({2, "two"}).second);
+  REQUIRE_FALSE(m.insert({2, "deux"}).second);
+  REQUIRE(m.at(2) == "two");
+
+  REQUIRE_FALSE(m.insert_or_assign(2, "deux"));
+  REQUIRE(m.insert_or_assign(4, "four"));
+  REQUIRE(m.size() == 4);
+  REQUIRE(m.at(2) == "deux");
+#ifdef SOCOW_NO_EXCEPTIONS
+  struct handled {};
+  socow_failure_handler previous = set_socow_failure_handler([](const char*) { throw handled(); });
+  REQUIRE_THROWS_AS(m.at(5), handled);
+  set_socow_failure_handler(previous);
+#else
+  REQUIRE_THROWS_AS(m.at(5), std::out_of_range);
+#endif
+
+  auto copy = m;
+  copy.at(1) = "un";
+  REQUIRE(m.at(1) == "one");
+  REQUIRE(copy.at(1) == "un");
+  REQUIRE(std::as_const(copy).at(3) == "three");
+
+  std::vector<int> keys;
+  for (const auto& [key, value] : m) {
+    keys.push_back(key);
+  }
+  REQUIRE(keys == std::vector<int>{1, 2, 3, 4});
+}
+
+TEST_CASE("Eytzinger set") {
+  socow_flat_set<int, 4> sorted;
+  for (int size = 0; size <= 70; ++size) {
+    CAPTURE(size);
+    socow_eytzinger_set<int> tree(sorted);
+    REQUIRE(tree.size() == sorted.size());
+    for (int key = -1; key <= 2 * size + 1; ++key) {
+      CAPTURE(key);
+      const int* expected = sorted.lower_bound(key);
+      const int* found = tree.lower_bound(key);
+      if (expected == sorted.end()) {
+        REQUIRE(found == nullptr);
+      } else {
+        REQUIRE(found != nullptr);
+        REQUIRE(*found == *expected);
+      }
+      REQUIRE(tree.contains(key) == sorted.contains(key));
+    }
+    sorted.insert(2 * size);
+  }
+}
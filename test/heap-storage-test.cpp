@@ -0,0 +1,204 @@
+#include "element.h"
+#include "heap-storage.h"
+#include "socow-vector.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+struct alignas(64) cache_line {
+  cache_line(int value)
+      : value(value) {}
+
+  int value;
+};
+
+template <std::size_t ALIGNMENT, typename Vector>
+bool aligned(const Vector& v) {
+  return reinterpret_cast<std::uintptr_t>(v.data()) % ALIGNMENT == 0;
+}
+
+} // namespace
+
+TEST_CASE("Only realloc_heap_storage reallocates") {
+  STATIC_REQUIRE_FALSE(reallocating_storage<heap_storage>);
+  STATIC_REQUIRE_FALSE(reallocating_storage<basic_heap_storage<64, 4096>>);
+  STATIC_REQUIRE(reallocating_storage<realloc_heap_storage>);
+}
+
+TEST_CASE("realloc_heap_storage reallocates relocatable buffers") {
+  realloc_heap_storage storage;
+
+  std::size_t small = 64;
+  std::size_t large = realloc_heap_storage::MMAP_THRESHOLD;
+
+  auto* memory = static_cast<char*>(storage.allocate_relocatable(small, 1));
+  std::memset(memory, 'a', small);
+
+  memory = static_cast<char*>(storage.reallocate(memory, small, 4 * small, 1));
+  REQUIRE(memory != nullptr);
+  REQUIRE(memory[small - 1] == 'a');
+
+  REQUIRE(storage.reallocate(memory, 4 * small, large, 1) == nullptr);
+  storage.deallocate_relocatable(memory, 4 * small, 1);
+
+  memory = static_cast<char*>(storage.allocate_relocatable(large, 1));
+  memory[0] = 'b';
+  memory[large - 1] = 'c';
+
+  char* moved = static_cast<char*>(storage.reallocate(memory, large, 2 * large, 1));
+#ifdef __linux__
+  REQUIRE(moved != nullptr);
+#endif
+  if (moved != nullptr) {
+    memory = moved;
+    REQUIRE(memory[0] == 'b');
+    REQUIRE(memory[large - 1] == 'c');
+    memory[2 * large - 1] = 'd';
+    storage.deallocate_relocatable(memory, 2 * large, 1);
+  } else {
+    storage.deallocate_relocatable(memory, large, 1);
+  }
+}
+
+TEST_CASE("Growth of trivially copyable elements") {
+  static constexpr std::size_t N = 1000;
+  static constexpr std::size_t LARGE = realloc_heap_storage::MMAP_THRESHOLD / sizeof(std::uint64_t);
+  using vector_type = socow_vector<std::uint64_t, 3, realloc_heap_storage>;
+
+  vector_type a;
+  for (std::size_t i = 0; i < N; ++i) {
+    a.push_back(i);
+  }
+  a.push_back(a[0]);
+  REQUIRE(a.back() == 0);
+
+  a.reserve(LARGE);
+  a.reserve(2 * LARGE);
+  REQUIRE(a.capacity() == 2 * LARGE);
+
+  vector_type b = a;
+  b.resize_for_overwrite(2 * LARGE + 1);
+  b.back() = 42;
+
+  a.shrink_to_fit();
+  REQUIRE(a.capacity() == N + 1);
+
+  for (std::size_t i = 0; i < N; ++i) {
+    CAPTURE(i);
+    REQUIRE(std::as_const(a)[i] == i);
+    REQUIRE(std::as_const(b)[i] == i);
+  }
+  REQUIRE(std::as_const(b).back() == 42);
+}
+
+TEST_CASE("Over-aligned elements") {
+  static constexpr std::size_t N = 100;
+
+  socow_vector<cache_line, 2> a;
+  for (std::size_t i = 0; i < N; ++i) {
+    a.push_back(static_cast<int>(i));
+    REQUIRE(aligned<64>(std::as_const(a)));
+  }
+  a.shrink_to_fit();
+  REQUIRE(aligned<64>(std::as_const(a)));
+  REQUIRE(std::as_const(a)[N - 1].value == N - 1);
+}
+
+TEST_CASE("Storage alignment") {
+  static constexpr std::size_t N = 1000;
+
+  socow_vector<float, 4, basic_heap_storage<64>> a;
+  socow_vector<char, 4, basic_heap_storage<128>> b;
+  for (std::size_t i = 0; i < N; ++i) {
+    a.push_back(static_cast<float>(i));
+    b.push_back(static_cast<char>(i));
+    if (i >= 4) {
+      REQUIRE(aligned<64>(std::as_const(a)));
+      REQUIRE(aligned<128>(std::as_const(b)));
+    }
+  }
+
+  socow_vector<float, 4, basic_heap_storage<64>> c = a;
+  c[0] = -1;
+  REQUIRE(aligned<64>(std::as_const(c)));
+  REQUIRE(std::as_const(a)[0] == 0);
+}
+
+#ifdef __linux__
+TEST_CASE("Huge page storage") {
+  using storage = basic_heap_storage<0, 4096>;
+  static constexpr std::size_t N = storage::HUGE_PAGE_SIZE / sizeof(int) + 1;
+
+  socow_vector<int, 4, storage> a;
+  a.reserve(N);
+  REQUIRE(aligned<storage::HUGE_PAGE_SIZE>(std::as_const(a)));
+  for (std::size_t i = 0; i < N; ++i) {
+    a.push_back(static_cast<int>(i));
+  }
+  a.push_back(-1);
+
+  socow_vector<element, 4, storage> b;
+  b.reserve(N / 4);
+  REQUIRE(aligned<storage::HUGE_PAGE_SIZE>(std::as_const(b)));
+  b.push_back(42);
+  REQUIRE(b[0] == 42);
+
+  REQUIRE(std::as_const(a)[N - 1] == N - 1);
+  REQUIRE(std::as_const(a).back() == -1);
+}
+#endif
+
+#ifdef __linux__
+TEST_CASE("Huge page storage keeps the alignment when remapping") {
+  using storage = basic_heap_storage<0, 4096, true>;
+  static constexpr std::size_t SIZE = storage::HUGE_PAGE_SIZE;
+  storage huge;
+
+  auto* memory = static_cast<char*>(huge.allocate_relocatable(SIZE, 1));
+  REQUIRE(reinterpret_cast<std::uintptr_t>(memory) % SIZE == 0);
+  memory[0] = 'a';
+  memory[SIZE - 1] = 'b';
+
+  // A page right after the buffer keeps it from growing in place, so mremap has to move it
+  void* blocker = ::mmap(memory + SIZE, 4096, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  REQUIRE(blocker != MAP_FAILED);
+
+  auto* moved = static_cast<char*>(huge.reallocate(memory, SIZE, 3 * SIZE, 1));
+  REQUIRE(moved != nullptr);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(moved) % SIZE == 0);
+  REQUIRE(moved[0] == 'a');
+  REQUIRE(moved[SIZE - 1] == 'b');
+  moved[3 * SIZE - 1] = 'c';
+
+  ::munmap(blocker, 4096);
+  huge.deallocate_relocatable(moved, 3 * SIZE, 1);
+}
+#endif
+
+#ifdef __linux__
+TEST_CASE("Allocation failure") {
+  // Mapped directly, so the failure doesn't depend on the allocator
+  basic_heap_storage<0, 4096> storage;
+  std::size_t bytes = std::size_t(1) << 60;
+
+#ifdef SOCOW_NO_EXCEPTIONS
+  struct handled {};
+  socow_failure_handler previous = set_socow_failure_handler([](const char*) { throw handled(); });
+  REQUIRE_THROWS_AS(storage.allocate(bytes, 1), handled);
+  set_socow_failure_handler(previous);
+#else
+  REQUIRE_THROWS_AS(storage.allocate(bytes, 1), std::bad_alloc);
+#endif
+}
+#endif
@@ -0,0 +1,117 @@
+#include "socow-interner.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+template class socow_interner<int, 3>;
+template class socow_interner<std::string, 2>;
+
+using int_interner = socow_interner<int, 3>;
+using int_vector = int_interner::vector_type;
+
+namespace {
+
+int_vector make_vector(int first, int count) {
+  int_vector result;
+  for (int i = 0; i < count; ++i) {
+    result.push_back(first + i);
+  }
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("Interner shares buffers of equal vectors") {
+  int_interner interner;
+  int_vector a = interner.intern(make_vector(0, 10));
+  int_vector b = interner.intern(make_vector(0, 10));
+  int_vector c = interner.intern(make_vector(1, 10));
+
+  REQUIRE(std::as_const(a).data() == std::as_const(b).data());
+  REQUIRE(std::as_const(a).data() != std::as_const(c).data());
+  REQUIRE(a._dynamic_data.use_count() == 3);
+  REQUIRE(interner.size() == 2);
+
+  REQUIRE(int_interner::equal(a, b));
+  REQUIRE_FALSE(int_interner::equal(a, c));
+  REQUIRE(int_interner::hash(a) == int_interner::hash(make_vector(0, 10)));
+}
+
+TEST_CASE("Interner leaves inline vectors alone") {
+  int_interner interner;
+  int_vector a = interner.intern(make_vector(0, 3));
+  int_vector b = interner.intern(make_vector(0, 3));
+  REQUIRE(a.small_object());
+  REQUIRE(interner.size() == 0);
+  REQUIRE(int_interner::equal(a, b));
+
+  // A heap vector that shrank compares element-wise with an inline one
+  int_vector shrunk = make_vector(0, 4);
+  shrunk.pop_back();
+  REQUIRE_FALSE(shrunk.small_object());
+  REQUIRE(int_interner::equal(interner.intern(shrunk), a));
+}
+
+TEST_CASE("Interned vectors stay copy-on-write") {
+  int_interner interner;
+  int_vector a = interner.intern(make_vector(0, 10));
+  a[0] = 100;
+  int_vector b = interner.intern(make_vector(0, 10));
+  REQUIRE(b[0] == 0);
+  REQUIRE(a[0] == 100);
+  REQUIRE_FALSE(int_interner::equal(a, b));
+}
+
+TEST_CASE("Interner drops dead entries") {
+  int_interner interner;
+  int_vector kept = interner.intern(make_vector(0, 10));
+  interner.intern(make_vector(1, 10));
+  REQUIRE(interner.size() == 2);
+  REQUIRE(interner.purge() == 1);
+  REQUIRE(interner.size() == 1);
+  REQUIRE(kept._dynamic_data.use_count() == 2);
+
+  // Dead entries don't pile up between explicit purges
+  for (int i = 0; i < 10000; ++i) {
+    interner.intern(make_vector(i, 10));
+  }
+  REQUIRE(interner.size() <= 128);
+
+  interner.clear();
+  REQUIRE(interner.size() == 0);
+  REQUIRE(kept._dynamic_data.use_count() == 1);
+  REQUIRE(kept[9] == 9);
+}
+
+TEST_CASE("Interner purges a table that stops growing") {
+  int_interner interner;
+  int_vector kept = interner.intern(make_vector(0, 10));
+  for (int i = 1; i < 50; ++i) {
+    interner.intern(make_vector(i, 10));
+  }
+  REQUIRE(interner.size() == 50);
+
+  // Lookups alone trigger the purge
+  for (int i = 0; i < 20; ++i) {
+    REQUIRE(int_interner::equal(interner.intern(make_vector(0, 10)), kept));
+  }
+  REQUIRE(interner.size() == 1);
+  REQUIRE(kept._dynamic_data.use_count() == 2);
+}
+
+TEST_CASE("Interner hashes elements one by one") {
+  socow_interner<std::string, 2> interner;
+  socow_vector<std::string, 2> a;
+  socow_vector<std::string, 2> b;
+  for (const char* s : {"alpha", "beta", "gamma"}) {
+    a.push_back(s);
+    b.push_back(s);
+  }
+  socow_vector<std::string, 2> x = interner.intern(a);
+  socow_vector<std::string, 2> y = interner.intern(std::move(b));
+  REQUIRE(std::as_const(x).data() == std::as_const(y).data());
+  REQUIRE(std::as_const(x).data() == std::as_const(a).data());
+}
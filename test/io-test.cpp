@@ -0,0 +1,152 @@
+#include "socow-vector.h"
+#include "test-utils.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#ifdef SOCOW_FD_IO
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <utility>
+
+namespace {
+
+#ifdef SOCOW_FD_IO
+class temporary_file {
+public:
+  temporary_file()
+      : file(std::tmpfile()) {
+    REQUIRE(file != nullptr);
+  }
+
+  temporary_file(const temporary_file&) = delete;
+  temporary_file& operator=(const temporary_file&) = delete;
+
+  ~temporary_file() {
+    std::fclose(file);
+  }
+
+  int fd() const {
+    return fileno(file);
+  }
+
+  void rewind() const {
+    REQUIRE(::lseek(fd(), 0, SEEK_SET) == 0);
+  }
+
+private:
+  std::FILE* file;
+};
+#endif
+
+class unseekable_buffer : public std::streambuf {
+public:
+  explicit unseekable_buffer(std::string& bytes) {
+    setg(bytes.data(), bytes.data(), bytes.data() + bytes.size());
+  }
+};
+
+template <std::size_t SMALL_SIZE>
+socow_vector<int, SMALL_SIZE> iota_vector(std::size_t size) {
+  socow_vector<int, SMALL_SIZE> result;
+  for (std::size_t i = 0; i < size; ++i) {
+    result.push_back(static_cast<int>(2 * i + 1));
+  }
+  return result;
+}
+
+} // namespace
+
+#ifdef SOCOW_FD_IO
+TEST_CASE("Write to and append from file descriptor") {
+  static constexpr std::size_t N = 1000;
+
+  temporary_file file;
+  socow_vector<int, 3> a = iota_vector<3>(N);
+  socow_vector<int, 3> b = a;
+  const int* shared = std::as_const(a).data();
+
+  a.write_to(file.fd());
+  REQUIRE(std::as_const(a).data() == shared);
+  REQUIRE(std::as_const(b).data() == shared);
+
+  file.rewind();
+  socow_vector<int, 3> c = iota_vector<3>(2);
+  REQUIRE(c.append_from(file.fd(), N * sizeof(int)) == N);
+  REQUIRE(c.size() == N + 2);
+  for (std::size_t i = 0; i < N; ++i) {
+    CAPTURE(i);
+    REQUIRE(c[i + 2] == a[i]);
+  }
+
+  SECTION("end of file") {
+    socow_vector<int, 3> d;
+    REQUIRE(d.append_from(file.fd(), 16) == 0);
+    REQUIRE(d.empty());
+  }
+
+  SECTION("pread") {
+    socow_vector<int, 3> d;
+    REQUIRE(d.append_from(file.fd(), 2 * N * sizeof(int), 10 * sizeof(int)) == N - 10);
+    REQUIRE(d.size() == N - 10);
+    REQUIRE(d.front() == a[10]);
+    REQUIRE(d.back() == a[N - 1]);
+  }
+
+  SECTION("small") {
+    file.rewind();
+    socow_vector<int, 3> d;
+    REQUIRE(d.append_from(file.fd(), 2 * sizeof(int) + 1) == 2);
+    REQUIRE(d.size() == 2);
+    REQUIRE(d[0] == 1);
+    REQUIRE(d[1] == 3);
+  }
+}
+#endif
+
+TEST_CASE("Append from stream") {
+  static constexpr std::size_t N = 5000;
+
+  socow_vector<int, 3> a = iota_vector<3>(N);
+  std::string bytes(reinterpret_cast<const char*>(std::as_const(a).data()), N * sizeof(int));
+
+  SECTION("seekable") {
+    std::istringstream in(bytes);
+    socow_vector<int, 3> b;
+    REQUIRE(b.append_from(in) == N);
+    REQUIRE(b.size() == N);
+    for (std::size_t i = 0; i < N; ++i) {
+      CAPTURE(i);
+      REQUIRE(b[i] == a[i]);
+    }
+  }
+
+  SECTION("partial element") {
+    std::istringstream in(bytes.substr(0, 3 * sizeof(int) - 1));
+    socow_vector<int, 3> b;
+    REQUIRE(b.append_from(in) == 2);
+    REQUIRE(b.size() == 2);
+    REQUIRE(b[1] == 3);
+
+    // The partial element stays in the stream
+    REQUIRE(in.good());
+    char rest[sizeof(int)];
+    in.read(rest, sizeof(int));
+    REQUIRE(in.gcount() == sizeof(int) - 1);
+    REQUIRE(std::memcmp(rest, bytes.data() + 2 * sizeof(int), sizeof(int) - 1) == 0);
+  }
+
+  SECTION("non-seekable") {
+    unseekable_buffer buffer(bytes);
+    std::istream in(&buffer);
+    REQUIRE(in.tellg() == std::istream::pos_type(-1));
+    socow_vector<int, 3> b;
+    REQUIRE(b.append_from(in) == N);
+    REQUIRE(b.back() == a[N - 1]);
+  }
+}
@@ -0,0 +1,161 @@
+#include "memfd-storage.h"
+#include "socow-vector.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+
+namespace {
+
+constexpr std::size_t PAGE_THRESHOLD = 4096;
+
+using mapped_vector = socow_vector<int, 4, memfd_storage<PAGE_THRESHOLD>>;
+
+mapped_vector iota_vector(std::size_t size) {
+  mapped_vector result;
+  for (std::size_t i = 0; i < size; ++i) {
+    result.push_back(static_cast<int>(i));
+  }
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("memfd storage clones mappings") {
+  static constexpr std::size_t BYTES = 4 * PAGE_THRESHOLD;
+
+  memfd_storage<PAGE_THRESHOLD> source;
+  auto* original = static_cast<char*>(source.allocate(BYTES, 1));
+  original[0] = 'a';
+  original[BYTES - 1] = 'z';
+
+  memfd_storage<PAGE_THRESHOLD> target;
+  auto* copy = static_cast<char*>(target.clone(source, original, BYTES));
+  REQUIRE(copy != nullptr);
+  REQUIRE(copy != original);
+  REQUIRE(copy[0] == 'a');
+  REQUIRE(copy[BYTES - 1] == 'z');
+
+  target.prepare_write();
+  copy[0] = 'b';
+  REQUIRE(original[0] == 'a');
+
+  source.prepare_write();
+  original[BYTES - 1] = 'y';
+  REQUIRE(copy[BYTES - 1] == 'z');
+
+  memfd_storage<PAGE_THRESHOLD> dirty;
+  REQUIRE(dirty.clone(source, original, BYTES) == nullptr);
+
+  target.deallocate(copy, BYTES, 1);
+  source.deallocate(original, BYTES, 1);
+}
+
+TEST_CASE("memfd storage keeps small buffers on the heap") {
+  memfd_storage<PAGE_THRESHOLD> storage;
+  void* memory = storage.allocate(PAGE_THRESHOLD - 1, 1);
+
+  memfd_storage<PAGE_THRESHOLD> target;
+  REQUIRE(target.clone(storage, memory, PAGE_THRESHOLD - 1) == nullptr);
+
+  storage.deallocate(memory, PAGE_THRESHOLD - 1, 1);
+}
+
+TEST_CASE("Writes to a cloned memfd vector reach its copies") {
+  static constexpr std::size_t N = 10 * PAGE_THRESHOLD;
+
+  vector<int, memfd_storage<PAGE_THRESHOLD>> a;
+  for (std::size_t i = 0; i < N; ++i) {
+    a.push_back(static_cast<int>(i));
+  }
+  vector<int, memfd_storage<PAGE_THRESHOLD>> b = a;
+
+  b[0] = -1;
+  *(b.end() - 1) = -2;
+  vector<int, memfd_storage<PAGE_THRESHOLD>> c = b;
+  REQUIRE(c[0] == -1);
+  REQUIRE(c.back() == -2);
+
+  a.data()[1] = -3;
+  vector<int, memfd_storage<PAGE_THRESHOLD>> d = a;
+  REQUIRE(d[1] == -3);
+  REQUIRE(std::as_const(b)[1] == 1);
+}
+
+TEST_CASE("Copy-on-write with memfd storage") {
+  static constexpr std::size_t N = 10 * PAGE_THRESHOLD;
+
+  mapped_vector a = iota_vector(N);
+  mapped_vector b = a;
+  REQUIRE(std::as_const(a).data() == std::as_const(b).data());
+
+  b[0] = -1;
+  REQUIRE(std::as_const(a).data() != std::as_const(b).data());
+  REQUIRE(std::as_const(a)[0] == 0);
+
+  a[1] = -2;
+  REQUIRE(std::as_const(b)[1] == 1);
+
+  mapped_vector c = a;
+  c[2] = -3;
+  REQUIRE(std::as_const(a)[2] == 2);
+  REQUIRE(std::as_const(c)[1] == -2);
+
+  b.push_back(-4);
+  REQUIRE(b.size() == N + 1);
+
+  for (std::size_t i = 3; i < N; ++i) {
+    CAPTURE(i);
+    REQUIRE(std::as_const(a)[i] == i);
+    REQUIRE(std::as_const(b)[i] == i);
+    REQUIRE(std::as_const(c)[i] == i);
+  }
+  REQUIRE(std::as_const(b).back() == -4);
+}
+
+TEST_CASE("memfd storage clones one source from several threads") {
+  static constexpr std::size_t BYTES = 16 * PAGE_THRESHOLD;
+  static constexpr int THREADS = 4;
+
+  memfd_storage<PAGE_THRESHOLD> source;
+  auto* original = static_cast<char*>(source.allocate(BYTES, 1));
+  original[BYTES - 1] = 'z';
+
+  std::array<memfd_storage<PAGE_THRESHOLD>, THREADS> targets;
+  std::array<void*, THREADS> copies{};
+  std::atomic<bool> start = false;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < THREADS; ++t) {
+    threads.emplace_back([&, t] {
+      while (!start.load()) {
+      }
+      copies[t] = targets[t].clone(source, original, BYTES);
+    });
+  }
+  start = true;
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // A copy racing with the remapping may give up, but at least the winner maps the file
+  int cloned = 0;
+  for (int t = 0; t < THREADS; ++t) {
+    if (copies[t] != nullptr) {
+      REQUIRE(static_cast<char*>(copies[t])[BYTES - 1] == 'z');
+      targets[t].deallocate(copies[t], BYTES, 1);
+      ++cloned;
+    }
+  }
+  REQUIRE(cloned >= 1);
+  REQUIRE(original[BYTES - 1] == 'z');
+  source.deallocate(original, BYTES, 1);
+}
+
+#endif
@@ -0,0 +1,124 @@
+#include "socow-profiler.h"
+#include "socow-vector.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+
+namespace {
+
+socow_profile_site make_site(std::size_t small_size, std::size_t element_size = sizeof(int)) {
+  return socow_profile_site("socow_vector", small_size, element_size, 8 + small_size * element_size, "test");
+}
+
+} // namespace
+
+TEST_CASE("Profile site estimates allocations") {
+  socow_profile_site site = make_site(3);
+  site.record_destruction(10, 0);
+
+  REQUIRE(site.estimate_for(10).allocations == 0);
+  REQUIRE(site.estimate_for(9).allocations == 2);
+  REQUIRE(site.estimate_for(3).allocations == 3);
+  REQUIRE(site.estimate_for(0).allocations == 5);
+}
+
+TEST_CASE("Profile site recommends SMALL_SIZE") {
+  SECTION("empty vectors") {
+    socow_profile_site site = make_site(8);
+    for (std::size_t i = 0; i != 100; ++i) {
+      site.record_destruction(0, 0);
+    }
+    REQUIRE(site.recommended_small_size() == 0);
+  }
+
+  SECTION("common small size") {
+    socow_profile_site site = make_site(3);
+    for (std::size_t i = 0; i != 100; ++i) {
+      site.record_destruction(5, 5);
+    }
+    REQUIRE(site.recommended_small_size() == 5);
+  }
+
+  SECTION("rare large vectors") {
+    socow_profile_site site = make_site(3, 16);
+    for (std::size_t i = 0; i != 100; ++i) {
+      site.record_destruction(2, 1);
+    }
+    site.record_destruction(40, 40);
+    REQUIRE(site.recommended_small_size() == 2);
+  }
+}
+
+TEST_CASE("Profile site report") {
+  socow_profile_site site = make_site(3, 16);
+  site.record_destruction(2, 1);
+  site.record_destruction(100, 100);
+  site.record_spill();
+  site.record_unpin(400);
+
+  std::ostringstream out;
+  site.report(out);
+  std::string report = out.str();
+
+  REQUIRE(report.find("vectors: 2, spills: 1, unpins: 1 (400 bytes copied)") != std::string::npos);
+  REQUIRE(report.find("peak size: 2:1 <=127:1") != std::string::npos);
+  REQUIRE(report.find("size at destruction: 1:1 <=127:1") != std::string::npos);
+  std::string suggested = "suggested SMALL_SIZE " + std::to_string(site.recommended_small_size()) + ":";
+  REQUIRE(report.find(suggested) != std::string::npos);
+}
+
+#ifdef SOCOW_PROFILE
+TEST_CASE("Vectors are attributed to their construction site") {
+  using vector = socow_vector<int, 3>;
+  socow_source_location here = socow_source_location::current();
+  {
+    vector a(here);
+    for (int i = 0; i != 10; ++i) {
+      a.push_back(i);
+    }
+    vector b(a, here);
+    b.push_back(10);
+    b.pop_back();
+  }
+
+  socow_profile_site& site = socow_profiler::site(typeid(vector), 3, sizeof(int), sizeof(vector), here);
+  std::ostringstream out;
+  site.report(out);
+  std::string report = out.str();
+
+  REQUIRE(report.find("vectors: 2, spills: 1, unpins: 1 (40 bytes copied)") != std::string::npos);
+  REQUIRE(report.find("peak size: 10:1 11:1") != std::string::npos);
+  REQUIRE(report.find("size at destruction: 10:2") != std::string::npos);
+}
+
+TEST_CASE("Moved vectors don't record their peak twice") {
+  using vector = socow_vector<int, 2>;
+  socow_source_location here = socow_source_location::current();
+  {
+    vector a(here);
+    for (int i = 0; i != 5; ++i) {
+      a.push_back(i);
+    }
+    vector b(std::move(a), here);
+    vector c(here);
+    c = std::move(b);
+  }
+
+  socow_profile_site& site = socow_profiler::site(typeid(vector), 2, sizeof(int), sizeof(vector), here);
+  std::ostringstream out;
+  site.report(out);
+  std::string report = out.str();
+
+  REQUIRE(report.find("vectors: 3, spills: 1") != std::string::npos);
+  REQUIRE(report.find("peak size: 0:2 5:1") != std::string::npos);
+}
+#else
+static_assert(std::is_empty_v<socow_profile_state>);
+#endif
+
+static_assert(!std::is_convertible_v<socow_source_location, socow_vector<int>>);
@@ -0,0 +1,178 @@
+#include "element.h"
+#include "socow-rope.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+template class socow_rope<int>;
+template class socow_rope<element>;
+
+namespace {
+
+socow_rope<int> make_rope(int first, int count) {
+  vector<int> leaf;
+  for (int i = 0; i < count; ++i) {
+    leaf.push_back(first + i);
+  }
+  return socow_rope<int>(std::move(leaf));
+}
+
+void require_sequence(const socow_rope<int>& rope, const std::vector<int>& expected) {
+  REQUIRE(rope.size() == expected.size());
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    CAPTURE(i);
+    REQUIRE(rope[i] == expected[i]);
+  }
+  REQUIRE(std::vector<int>(rope.begin(), rope.end()) == expected);
+}
+
+// An AVL tree of n leaves is at most about 1.44 log2(n) high
+void require_balanced(const socow_rope<int>& rope, std::size_t leaves) {
+  REQUIRE(static_cast<double>(rope.height()) <= 1.45 * std::log2(static_cast<double>(leaves) + 2) + 1);
+}
+
+} // namespace
+
+TEST_CASE("Rope construction") {
+  socow_rope<int> empty;
+  REQUIRE(empty.empty());
+  REQUIRE(empty.begin() == empty.end());
+
+  socow_rope<int> list = {1, 2, 3};
+  require_sequence(list, {1, 2, 3});
+
+  std::vector<int> values = {4, 5};
+  require_sequence(socow_rope<int>(values), {4, 5});
+
+  vector<int> leaf;
+  leaf.push_back(7);
+  const int* buffer = leaf.data();
+  socow_rope<int> adopted(std::move(leaf));
+  REQUIRE(&adopted[0] == buffer);
+}
+
+TEST_CASE("Rope concatenation shares leaves") {
+  socow_rope<int> a = make_rope(0, 5);
+  socow_rope<int> b = make_rope(5, 5);
+  const int* a_data = &a[0];
+  const int* b_data = &b[0];
+
+  socow_rope<int> c = a + b;
+  require_sequence(c, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+  REQUIRE(&c[0] == a_data);
+  REQUIRE(&c[5] == b_data);
+  require_sequence(a, {0, 1, 2, 3, 4});
+}
+
+TEST_CASE("Rope of many fragments stays balanced") {
+  socow_rope<int> rope;
+  std::vector<int> expected;
+  static constexpr int N = 1000;
+  for (int i = 0; i < N; ++i) {
+    if (i % 2 == 0) {
+      rope += make_rope(i * 3, 3);
+    } else {
+      rope = make_rope(i * 3, 3) + rope;
+    }
+    REQUIRE(rope.size() == static_cast<std::size_t>(3 * (i + 1)));
+  }
+  require_balanced(rope, N);
+
+  std::size_t segments = 0;
+  std::size_t elements = 0;
+  rope.for_each_segment([&](std::span<const int> segment) {
+    ++segments;
+    elements += segment.size();
+  });
+  REQUIRE(segments == N);
+  REQUIRE(elements == rope.size());
+
+  for (int i = N - 1; i >= 0; --i) {
+    if (i % 2 == 1) {
+      for (int j = 0; j < 3; ++j) {
+        expected.push_back(i * 3 + j);
+      }
+    }
+  }
+  for (int i = 0; i < N; ++i) {
+    if (i % 2 == 0) {
+      for (int j = 0; j < 3; ++j) {
+        expected.push_back(i * 3 + j);
+      }
+    }
+  }
+  require_sequence(rope, expected);
+}
+
+TEST_CASE("Rope split") {
+  socow_rope<int> rope;
+  for (int i = 0; i < 20; ++i) {
+    rope += make_rope(i * 5, 5);
+  }
+  std::vector<int> all(100);
+  std::iota(all.begin(), all.end(), 0);
+
+  for (std::size_t pos = 0; pos <= rope.size(); ++pos) {
+    CAPTURE(pos);
+    auto [left, right] = rope.split(pos);
+    require_sequence(left, std::vector<int>(all.begin(), all.begin() + pos));
+    require_sequence(right, std::vector<int>(all.begin() + pos, all.end()));
+    require_balanced(left, 21);
+    require_balanced(right, 21);
+    REQUIRE(left + right == rope);
+  }
+
+  require_sequence(rope.substr(7, 6), {7, 8, 9, 10, 11, 12});
+  require_sequence(rope.substr(95), {95, 96, 97, 98, 99});
+
+#ifdef SOCOW_NO_EXCEPTIONS
+  struct handled {};
+  socow_failure_handler previous = set_socow_failure_handler([](const char*) { throw handled(); });
+  REQUIRE_THROWS_AS(rope.split(101), handled);
+  REQUIRE_THROWS_AS(rope.at(100), handled);
+  set_socow_failure_handler(previous);
+#else
+  REQUIRE_THROWS_AS(rope.split(101), std::out_of_range);
+  REQUIRE_THROWS_AS(rope.at(100), std::out_of_range);
+#endif
+}
+
+TEST_CASE("Rope insert and erase") {
+  socow_rope<int> rope = make_rope(0, 10);
+  rope.insert(5, make_rope(100, 3));
+  require_sequence(rope, {0, 1, 2, 3, 4, 100, 101, 102, 5, 6, 7, 8, 9});
+  rope.erase(2, 5);
+  require_sequence(rope, {0, 1, 102, 5, 6, 7, 8, 9});
+  rope.erase(6, 100);
+  require_sequence(rope, {0, 1, 102, 5, 6, 7});
+}
+
+TEST_CASE("Rope elements are not copied") {
+  element::no_new_intances_guard ig;
+
+  vector<element> leaf;
+  for (int i = 0; i < 10; ++i) {
+    leaf.push_back(element(i));
+  }
+  socow_rope<element> a(std::move(leaf));
+
+  element::operation_counter operations;
+  socow_rope<element> b = a + a;
+  auto [left, right] = b.split(15);
+  socow_rope<element> c = right + left;
+  std::size_t copies = operations.copies();
+  std::size_t moves = operations.moves();
+
+  REQUIRE(copies == 0);
+  REQUIRE(moves == 0);
+  REQUIRE(c.size() == 20);
+  REQUIRE(c[0] == 5);
+  REQUIRE(c[5] == 0);
+}
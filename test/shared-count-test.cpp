@@ -0,0 +1,206 @@
+#include "allocation-counter.h"
+#include "shared-count.h"
+#include "shared-data.h"
+#include "socow-vector.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template class shared_data<int, local_count>;
+template class shared_data<int, atomic_count>;
+template class shared_data<int, biased_count>;
+
+namespace {
+
+struct tracked {
+  explicit tracked(int) {}
+  tracked(const tracked&) = delete;
+
+  ~tracked() {
+    destroyed.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  inline static std::atomic<int> destroyed = 0;
+};
+
+using biased_data = shared_data<tracked, biased_count>;
+
+int destroyed() {
+  return tracked::destroyed.load();
+}
+
+template <typename F>
+void on_thread(F f) {
+  std::thread thread(std::move(f));
+  thread.join();
+}
+
+} // namespace
+
+TEST_CASE("Biased count on the owner thread") {
+  int before = destroyed();
+  {
+    biased_data a(0);
+    REQUIRE(a.use_count() == 1);
+    {
+      biased_data b = a;
+      biased_data c = b;
+      REQUIRE(a.use_count() == 3);
+    }
+    REQUIRE(a.use_count() == 1);
+    REQUIRE(destroyed() == before);
+  }
+  REQUIRE(destroyed() == before + 1);
+}
+
+TEST_CASE("Biased count released last by another thread") {
+  int before = destroyed();
+  biased_data a(0);
+  biased_data b = a;
+  on_thread([copy = std::move(b)]() mutable {
+    REQUIRE(copy.use_count() == 2);
+    biased_data another = copy;
+    REQUIRE(copy.use_count() == 3);
+  });
+  REQUIRE(a.use_count() == 1);
+
+  // The owner's copy went away on the other thread: the count is queued until the owner merges it
+  biased_data c = a;
+  on_thread([copy = std::move(a)]() mutable { biased_data dropped = std::move(copy); });
+  REQUIRE(c.use_count() == 1);
+  REQUIRE(destroyed() == before);
+
+  on_thread([copy = std::move(c)]() mutable { biased_data dropped = std::move(copy); });
+  REQUIRE(destroyed() == before);
+  socow_merge_queued_releases();
+  REQUIRE(destroyed() == before + 1);
+}
+
+TEST_CASE("Biased count queues releases without allocating") {
+  int before = destroyed();
+  static constexpr int COUNTS = 1000;
+  std::vector<biased_data> originals;
+  std::vector<biased_data> copies;
+  for (int i = 0; i < COUNTS; ++i) {
+    originals.emplace_back(i);
+    copies.push_back(originals.back());
+  }
+
+  std::size_t allocations = 0;
+  on_thread([&] {
+    allocation_counter counter;
+    for (biased_data& original : originals) {
+      original = biased_data();
+    }
+    allocations = counter.allocations();
+  });
+  REQUIRE(allocations == 0);
+  REQUIRE(destroyed() == before);
+
+  socow_merge_queued_releases();
+  copies.clear();
+  REQUIRE(destroyed() == before + COUNTS);
+}
+
+TEST_CASE("Biased count merged when the owner drops its references") {
+  int before = destroyed();
+  biased_data a(0);
+  biased_data held;
+  on_thread([&] { held = biased_data(a); });
+  a = biased_data();
+  REQUIRE(held.use_count() == 1);
+  REQUIRE(destroyed() == before);
+
+  on_thread([copy = std::move(held)]() mutable { biased_data dropped = std::move(copy); });
+  REQUIRE(destroyed() == before + 1);
+}
+
+TEST_CASE("Biased count of an exited owner") {
+  int before = destroyed();
+  biased_data orphan;
+  on_thread([&] {
+    biased_data created(0);
+    biased_data copy = created;
+    orphan = std::move(copy);
+  });
+  REQUIRE(orphan.use_count() == 1);
+  orphan = biased_data();
+  REQUIRE(destroyed() == before + 1);
+
+  // The owner left with a queued release, which it had to finish itself
+  on_thread([&] {
+    biased_data created(0);
+    biased_data copy = created;
+    on_thread([moved = std::move(copy)]() mutable { biased_data dropped = std::move(moved); });
+    REQUIRE(destroyed() == before + 1);
+    orphan = std::move(created);
+  });
+  REQUIRE(orphan.use_count() == 1);
+  orphan = biased_data();
+  REQUIRE(destroyed() == before + 2);
+}
+
+TEST_CASE("Biased count under concurrent copies") {
+  int before = destroyed();
+  static constexpr std::size_t THREADS = 4;
+  static constexpr std::size_t COPIES = 10'000;
+  {
+    biased_data a(0);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < THREADS; ++t) {
+      threads.emplace_back([&a] {
+        std::vector<biased_data> copies;
+        for (std::size_t i = 0; i < COPIES; ++i) {
+          copies.push_back(a);
+          if (i % 3 == 0) {
+            copies.pop_back();
+          }
+        }
+      });
+    }
+    for (std::size_t i = 0; i < COPIES; ++i) {
+      biased_data copy = a;
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    REQUIRE(a.use_count() == 1);
+  }
+  REQUIRE(destroyed() == before + 1);
+}
+
+TEST_CASE("Vectors shared between threads") {
+  socow_vector<int, 3> original;
+  for (int i = 0; i < 1000; ++i) {
+    original.push_back(i);
+  }
+
+  std::vector<std::thread> threads;
+  std::atomic<int> failures = 0;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&original, &failures, t] {
+      for (int round = 0; round < 100; ++round) {
+        socow_vector<int, 3> copy = original;
+        const socow_vector<int, 3>& view = copy;
+        if (std::accumulate(view.begin(), view.end(), 0) != 999 * 1000 / 2) {
+          ++failures;
+        }
+        copy[0] = t;
+        if (std::as_const(copy).data() == std::as_const(original).data() || copy[0] != t) {
+          ++failures;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  REQUIRE(failures == 0);
+  REQUIRE(std::as_const(original)[0] == 0);
+}
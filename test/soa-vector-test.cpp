@@ -0,0 +1,163 @@
+#include "socow-soa-vector.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+
+template class socow_soa_vector<4, int, double, std::string>;
+template class socow_soa_vector<4, float, bool>;
+
+using particles = socow_soa_vector<4, int, double, std::string>;
+
+namespace {
+
+particles make_particles(std::size_t n) {
+  particles result;
+  for (std::size_t i = 0; i < n; ++i) {
+    result.push_back(static_cast<int>(i), 0.5 * static_cast<double>(i), std::to_string(i));
+  }
+  return result;
+}
+
+// Copying throws while `fail` is set
+struct fragile {
+  inline static bool fail = false;
+
+  fragile(int value)
+      : value(value) {}
+
+  fragile(const fragile& other)
+      : value(other.value) {
+    if (fail) {
+      throw std::runtime_error("copy");
+    }
+  }
+
+  fragile(fragile&&) noexcept = default;
+  fragile& operator=(const fragile&) = default;
+  fragile& operator=(fragile&&) noexcept = default;
+
+  int value;
+};
+
+} // namespace
+
+TEST_CASE("Structure of arrays push back") {
+  for (std::size_t n : {3, 20}) {
+    CAPTURE(n);
+    particles p = make_particles(n);
+    REQUIRE(p.size() == n);
+    REQUIRE(p.capacity() >= n);
+
+    std::span<const int> ids = std::as_const(p).column<0>();
+    REQUIRE(ids.size() == n);
+    REQUIRE(std::accumulate(ids.begin(), ids.end(), 0) == static_cast<int>(n * (n - 1) / 2));
+
+    for (std::size_t i = 0; i < n; ++i) {
+      auto [id, mass, name] = std::as_const(p)[i];
+      REQUIRE(id == static_cast<int>(i));
+      REQUIRE(mass == 0.5 * static_cast<double>(i));
+      REQUIRE(name == std::to_string(i));
+    }
+
+    p.pop_back();
+    REQUIRE(p.size() == n - 1);
+    REQUIRE(std::get<2>(p.back()) == std::to_string(n - 2));
+  }
+}
+
+TEST_CASE("Structure of arrays row access") {
+  particles p = make_particles(10);
+  auto [id, mass, name] = p[3];
+  id = 30;
+  mass = 1.5;
+  name = "three";
+
+  REQUIRE(std::as_const(p)[3] == std::make_tuple(30, 1.5, std::string("three")));
+  REQUIRE(std::get<0>(std::as_const(p)[4]) == 4);
+}
+
+TEST_CASE("Structure of arrays columns unshare independently") {
+  particles a = make_particles(20);
+  particles b = a;
+  REQUIRE(std::as_const(b).column<0>().data() == std::as_const(a).column<0>().data());
+  REQUIRE(std::as_const(b).column<2>().data() == std::as_const(a).column<2>().data());
+
+  for (double& mass : b.column<1>()) {
+    mass *= 2;
+  }
+
+  REQUIRE(std::as_const(b).column<0>().data() == std::as_const(a).column<0>().data());
+  REQUIRE(std::as_const(b).column<1>().data() != std::as_const(a).column<1>().data());
+  REQUIRE(std::as_const(b).column<2>().data() == std::as_const(a).column<2>().data());
+  REQUIRE(std::get<1>(std::as_const(a)[5]) == 2.5);
+  REQUIRE(std::get<1>(std::as_const(b)[5]) == 5.0);
+
+  socow_memory_usage usage = a.memory_usage();
+  REQUIRE(usage.inline_bytes == sizeof(particles));
+  REQUIRE(usage.shared_bytes < static_cast<double>(usage.heap_bytes));
+}
+
+TEST_CASE("Structure of arrays of move-only fields") {
+  socow_soa_vector<2, std::unique_ptr<int>, int> v;
+  for (int i = 0; i < 5; ++i) {
+    v.push_back(std::make_unique<int>(i), i);
+  }
+  socow_soa_vector<2, std::unique_ptr<int>, int> moved = std::move(v);
+  REQUIRE(moved.size() == 5);
+  REQUIRE(*std::get<0>(moved[4]) == 4);
+
+  moved.swap(v);
+  REQUIRE(v.size() == 5);
+  v.clear();
+  REQUIRE(v.empty());
+}
+
+TEST_CASE("Structure of arrays with a bool field") {
+  socow_soa_vector<4, float, bool> v;
+  for (int i = 0; i < 10; ++i) {
+    v.push_back(static_cast<float>(i), i % 3 == 0);
+  }
+  socow_soa_vector<4, float, bool> copy = v;
+
+  auto [value, flag] = v[4];
+  flag = true;
+  REQUIRE(std::get<1>(std::as_const(v)[4]));
+  REQUIRE_FALSE(std::get<1>(std::as_const(copy)[4]));
+
+  std::size_t flags = 0;
+  for (bool set : std::as_const(v).column<1>()) {
+    flags += set ? 1 : 0;
+  }
+  REQUIRE(flags == 5);
+  REQUIRE(std::as_const(v).column<1>().size() == 10);
+}
+
+TEST_CASE("Structure of arrays pop back of a shared copy is strong") {
+  socow_soa_vector<2, int, fragile> a;
+  for (int i = 0; i < 10; ++i) {
+    a.push_back(i, i);
+  }
+  socow_soa_vector<2, int, fragile> b = a;
+
+  fragile::fail = true;
+  REQUIRE_THROWS_AS(b.pop_back(), std::runtime_error);
+  fragile::fail = false;
+
+  REQUIRE(b.size() == 10);
+  REQUIRE(std::as_const(b).column<0>().size() == 10);
+  REQUIRE(std::as_const(b).column<1>().size() == 10);
+  REQUIRE(std::get<0>(std::as_const(b).back()) == 9);
+  REQUIRE(std::get<1>(std::as_const(b).back()).value == 9);
+
+  b.pop_back();
+  REQUIRE(b.size() == 9);
+  REQUIRE(a.size() == 10);
+}
@@ -0,0 +1,144 @@
+#include "socow-string.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+
+template class basic_socow_string<7>;
+template class basic_socow_string<0>;
+
+using small_string = basic_socow_string<7>;
+
+namespace {
+
+void require_terminated(const small_string& s, std::string_view expected) {
+  REQUIRE(s.size() == expected.size());
+  REQUIRE(s.view() == expected);
+  REQUIRE(std::strlen(s.c_str()) == expected.size());
+}
+
+} // namespace
+
+TEST_CASE("String construction") {
+  require_terminated(small_string(), "");
+  require_terminated(small_string("short"), "short");
+  require_terminated(small_string("a longer string that spills"), "a longer string that spills");
+  require_terminated(small_string(20, 'x'), std::string(20, 'x'));
+
+  small_string s = "1234567";
+  REQUIRE(s.capacity() == 7);
+  std::string_view view = s;
+  REQUIRE(view == "1234567");
+
+#ifndef SOCOW_PROFILE
+  STATIC_REQUIRE(sizeof(socow_string) <= SOCOW_CACHE_LINE_SIZE);
+#endif
+}
+
+TEST_CASE("String append") {
+  small_string s;
+  std::string expected;
+  for (int i = 0; i < 50; ++i) {
+    char ch = static_cast<char>('a' + i % 26);
+    s += ch;
+    expected += ch;
+    require_terminated(s, expected);
+  }
+  s += "tail";
+  s.append(3, '!');
+  expected += "tail!!!";
+  require_terminated(s, expected);
+
+  s.pop_back();
+  expected.pop_back();
+  require_terminated(s, expected);
+
+  s.resize(10);
+  require_terminated(s, expected.substr(0, 10));
+  s.resize(12, '?');
+  require_terminated(s, expected.substr(0, 10) + "??");
+}
+
+TEST_CASE("String append from itself") {
+  small_string s = "abcd";
+  s.append(s.view());
+  require_terminated(s, "abcdabcd");
+  s.append(s.view().substr(2, 3));
+  require_terminated(s, "abcdabcdcda");
+  s += s;
+  require_terminated(s, "abcdabcdcdaabcdabcdcda");
+}
+
+TEST_CASE("String copy-on-write") {
+  small_string a = "a string longer than seven chars";
+  small_string b = a;
+  REQUIRE(b.c_str() == a.c_str());
+
+  b[0] = 'A';
+  REQUIRE(b.c_str() != a.c_str());
+  REQUIRE(a == "a string longer than seven chars");
+  REQUIRE(b == "A string longer than seven chars");
+
+  small_string c = a;
+  c.clear();
+  require_terminated(c, "");
+  REQUIRE(a == "a string longer than seven chars");
+}
+
+TEST_CASE("String append unshares once") {
+  small_string a(100, 'x');
+  small_string b = a;
+  b += "more";
+
+  // Copied straight into a buffer that fits, not copied and then grown
+  REQUIRE(b.capacity() == 104);
+  REQUIRE(b.size() == 104);
+  REQUIRE(a.size() == 100);
+}
+
+TEST_CASE("String find") {
+  small_string s = "the quick brown fox jumps over the lazy dog";
+  REQUIRE(s.find('q') == 4);
+  REQUIRE(s.find('t', 1) == 31);
+  REQUIRE(s.find('z', 40) == small_string::npos);
+  REQUIRE(s.find("the") == 0);
+  REQUIRE(s.find("the", 1) == 31);
+  REQUIRE(s.find("dog") == s.size() - 3);
+  REQUIRE(s.find("cat") == small_string::npos);
+  REQUIRE(s.find("") == 0);
+  REQUIRE(s.find("", s.size()) == s.size());
+  REQUIRE(s.find("x", s.size() + 1) == small_string::npos);
+  REQUIRE(s.contains("brown"));
+  REQUIRE(s.starts_with("the"));
+  REQUIRE(s.ends_with("dog"));
+  REQUIRE(s.substr(4, 5) == "quick");
+
+  // Enough false starts to switch to the linear search
+  small_string repeated(100, 'a');
+  repeated += "b";
+  REQUIRE(repeated.find("aaab") == 97);
+  REQUIRE(repeated.find("aaac") == small_string::npos);
+  REQUIRE(repeated.find(repeated.view()) == 0);
+}
+
+TEST_CASE("String comparison and hashing") {
+  socow_string a = "apple";
+  socow_string b = "banana";
+  REQUIRE(a < b);
+  REQUIRE(a == "apple");
+  REQUIRE(a != b);
+  REQUIRE(a + " and " + b == "apple and banana");
+
+  std::unordered_set<socow_string> set = {a, b};
+  REQUIRE(set.count(socow_string("apple")) == 1);
+
+  std::ostringstream out;
+  out << b;
+  REQUIRE(out.str() == "banana");
+}
@@ -5,7 +5,12 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <memory>
+
+template class socow_vector<int, 0>;
 template class socow_vector<int, 3>;
+template class socow_vector<std::unique_ptr<int>, 3>;
+template class socow_vector<element, 0>;
 template class socow_vector<element, 3>;
 template class socow_vector<element, 10>;
 
@@ -3,7 +3,9 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <array>
 #include <iterator>
+#include <memory>
 #include <ranges>
 #include <type_traits>
 
@@ -23,3 +25,42 @@ TEST_CASE("Vector is contiguous") {
 
   STATIC_REQUIRE(std::ranges::contiguous_range<socow_vector<element, 3>>);
 }
+
+TEST_CASE("Copy operations are constrained") {
+  STATIC_REQUIRE(std::is_copy_constructible_v<socow_vector<element, 3>>);
+  STATIC_REQUIRE(std::is_copy_assignable_v<socow_vector<element, 3>>);
+
+  STATIC_REQUIRE_FALSE(std::is_copy_constructible_v<socow_vector<std::unique_ptr<int>, 3>>);
+  STATIC_REQUIRE_FALSE(std::is_copy_assignable_v<socow_vector<std::unique_ptr<int>, 3>>);
+  STATIC_REQUIRE(std::is_nothrow_move_constructible_v<socow_vector<std::unique_ptr<int>, 3>>);
+  STATIC_REQUIRE(std::is_nothrow_move_assignable_v<socow_vector<std::unique_ptr<int>, 3>>);
+}
+
+TEST_CASE("Default small size fills a cache line") {
+  STATIC_REQUIRE(std::is_same_v<socow_vector<int>, socow_vector<int, socow_small_size<int>()>>);
+
+  STATIC_REQUIRE(sizeof(socow_layout<char, socow_small_size<char>()>) <= SOCOW_CACHE_LINE_SIZE);
+  STATIC_REQUIRE(sizeof(socow_layout<char, socow_small_size<char>() + 1>) > SOCOW_CACHE_LINE_SIZE);
+  STATIC_REQUIRE(sizeof(socow_layout<int, socow_small_size<int>()>) <= SOCOW_CACHE_LINE_SIZE);
+  STATIC_REQUIRE(sizeof(socow_layout<int, socow_small_size<int>() + 1>) > SOCOW_CACHE_LINE_SIZE);
+  STATIC_REQUIRE(sizeof(socow_layout<element, socow_small_size<element>()>) <= SOCOW_CACHE_LINE_SIZE);
+  STATIC_REQUIRE(sizeof(socow_layout<element, socow_small_size<element>() + 1>) > SOCOW_CACHE_LINE_SIZE);
+
+  if constexpr (sizeof(void*) == 8 && sizeof(std::size_t) == 8) {
+    STATIC_REQUIRE(socow_small_size<char>() == 56);
+    STATIC_REQUIRE(socow_small_size<int>() == 14);
+    STATIC_REQUIRE(socow_small_size<double>() == 7);
+    STATIC_REQUIRE(socow_small_size<void*>() == 7);
+    STATIC_REQUIRE(socow_small_size<std::unique_ptr<int>>() == 7);
+    STATIC_REQUIRE(socow_small_size<int, 128>() == 30);
+    STATIC_REQUIRE(socow_small_size<char, 16>() == 8);
+    STATIC_REQUIRE(socow_small_size<char, 8>() == 0);
+  }
+  STATIC_REQUIRE(socow_small_size<std::array<char, 100>>() == 0);
+
+#ifndef SOCOW_PROFILE
+  STATIC_REQUIRE(sizeof(socow_vector<char>) == sizeof(socow_layout<char, socow_small_size<char>()>));
+  STATIC_REQUIRE(sizeof(socow_vector<int>) <= SOCOW_CACHE_LINE_SIZE);
+  STATIC_REQUIRE(sizeof(socow_vector<double>) <= SOCOW_CACHE_LINE_SIZE);
+#endif
+}
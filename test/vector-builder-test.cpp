@@ -0,0 +1,102 @@
+#include "socow-vector-builder.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template class socow_vector<int, 3>::builder;
+template class socow_vector<std::string, 3>::builder;
+
+namespace {
+
+template <typename T, typename F>
+socow_vector<T, 3> build_in_parallel(std::size_t chunks, std::size_t per_chunk, std::size_t threads, F make) {
+  typename socow_vector<T, 3>::builder builder(chunks);
+  std::vector<std::thread> producers;
+  for (std::size_t c = 0; c < chunks; ++c) {
+    producers.emplace_back([&, c] {
+      for (std::size_t i = 0; i < per_chunk; ++i) {
+        builder[c].push_back(make(c * per_chunk + i));
+      }
+    });
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  REQUIRE(builder.size() == chunks * per_chunk);
+  socow_vector<T, 3> result = builder.finish(threads);
+  REQUIRE(builder.size() == 0);
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("Builder concatenates chunks in order") {
+  for (std::size_t threads : {1, 3, 8}) {
+    CAPTURE(threads);
+    // Large enough to split the relocation between threads
+    static constexpr std::size_t PER_CHUNK = 100'000;
+    socow_vector<int, 3> v =
+        build_in_parallel<int>(8, PER_CHUNK, threads, [](std::size_t i) { return static_cast<int>(i); });
+    REQUIRE(v.size() == 8 * PER_CHUNK);
+    REQUIRE(v.capacity() == v.size());
+    for (std::size_t i = 0; i < v.size(); ++i) {
+      if (std::as_const(v)[i] != static_cast<int>(i)) {
+        FAIL("element " << i << " is " << std::as_const(v)[i]);
+      }
+    }
+  }
+}
+
+TEST_CASE("Builder relocates non-trivial elements") {
+  socow_vector<std::string, 3> v = build_in_parallel<std::string>(5, 20'000, 4, [](std::size_t i) {
+    return std::string(30, 'a') + std::to_string(i);
+  });
+  REQUIRE(v.size() == 100'000);
+  for (std::size_t i = 0; i < v.size(); i += 997) {
+    REQUIRE(std::as_const(v)[i] == std::string(30, 'a') + std::to_string(i));
+  }
+
+  socow_vector<std::string, 3> copy = v;
+  REQUIRE(std::as_const(copy).data() == std::as_const(v).data());
+}
+
+TEST_CASE("Builder with empty and small chunks") {
+  socow_vector<int, 3>::builder builder(4);
+  builder[1].push_back(1);
+  builder[3].push_back(2);
+  socow_vector<int, 3> small = builder.finish();
+  REQUIRE(small.size() == 2);
+  REQUIRE(small.capacity() == 3);
+  REQUIRE(small[0] == 1);
+  REQUIRE(small[1] == 2);
+
+  builder[2].push_back(3);
+  for (int i = 4; i < 10; ++i) {
+    builder[0].push_back(i);
+  }
+  socow_vector<int, 3> large = builder.finish();
+  REQUIRE(large.size() == 7);
+  REQUIRE(large[0] == 4);
+  REQUIRE(large[5] == 9);
+  REQUIRE(large[6] == 3);
+
+  REQUIRE(socow_vector<int, 3>::builder(0).finish().empty());
+}
+
+TEST_CASE("Builder of move-only elements") {
+  socow_vector<std::unique_ptr<int>, 3>::builder builder(2);
+  for (int i = 0; i < 5; ++i) {
+    builder[static_cast<std::size_t>(i % 2)].push_back(std::make_unique<int>(i));
+  }
+  socow_vector<std::unique_ptr<int>, 3> v = builder.finish();
+  REQUIRE(v.size() == 5);
+  REQUIRE(*v[0] == 0);
+  REQUIRE(*v[2] == 4);
+  REQUIRE(*v[3] == 1);
+}
@@ -1,8 +1,14 @@
+#include "memfd-storage.h"
 #include "socow-vector.h"
 #include "test-utils.h"
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include <type_traits>
 #include <utility>
 
 TEST_CASE("Default constructor") {
@@ -11,6 +17,11 @@ TEST_CASE("Default constructor") {
   socow_vector<element, 3> a;
   assert_empty_storage(a);
   REQUIRE(ig.check_no_new_instances());
+
+  // Copy-list-initialization from empty braces
+  STATIC_REQUIRE(std::is_nothrow_default_constructible_v<socow_vector<element, 3>>);
+  socow_vector<element, 3> b = {};
+  assert_empty_storage(b);
 }
 
 TEST_CASE("Push back") {
@@ -483,3 +494,381 @@ TEST_CASE("Copy-on-write") {
   REQUIRE(std::as_const(b[0]) == 42);
   REQUIRE(std::as_const(c[0]) == 1);
 }
+
+TEST_CASE("Pure copy-on-write") {
+  element::no_new_intances_guard ig;
+
+  static constexpr std::size_t N = 50;
+
+  socow_vector<element, 0> a;
+  REQUIRE(a.capacity() == 0);
+  mass_push_back(a, N);
+  snapshot s(a);
+
+  socow_vector<element, 0> b = a;
+  socow_vector<element, 0> c;
+  c = b;
+  s.full_verify(b);
+  s.full_verify(c);
+
+  b[0] = 42;
+  REQUIRE(std::as_const(a[0]) == 1);
+  REQUIRE(std::as_const(b[0]) == 42);
+  REQUIRE(std::as_const(c[0]) == 1);
+
+  socow_vector<element, 0> d;
+  d.swap(c);
+  REQUIRE(c.empty());
+  REQUIRE(d.size() == N);
+  c = std::move(d);
+  REQUIRE(c.size() == N);
+
+  c.clear();
+  REQUIRE(c.empty());
+  c.insert(c.begin(), 7);
+  REQUIRE(c.size() == 1);
+  REQUIRE(c[0] == 7);
+}
+
+TEST_CASE("Pure copy-on-write has no inline state") {
+  STATIC_REQUIRE(sizeof(socow_vector_fields<int, 0, heap_storage>) == sizeof(shared_data<vector<int>>));
+
+  socow_vector<int, 0> a;
+  REQUIRE_FALSE(a.small_object());
+  REQUIRE(std::as_const(a).data() == nullptr);
+  REQUIRE(a.begin() == a.end());
+  REQUIRE(a.memory_usage().heap_bytes == 0);
+  a.reserve(0);
+  a.resize_for_overwrite(0);
+  REQUIRE(a.append_uninitialized(0, [](int*) {}) == 0);
+  REQUIRE(a.capacity() == 0);
+  REQUIRE(a.release().data() == nullptr);
+
+  REQUIRE(a.append_uninitialized(3, [](int* tail) { std::fill_n(tail, 3, 5); }) == 3);
+  REQUIRE(a.size() == 3);
+  REQUIRE(a[2] == 5);
+
+  socow_vector<int, 0> b = a;
+  b.clear();
+  REQUIRE(b.capacity() == 0);
+  REQUIRE(a.size() == 3);
+
+  a.pop_back();
+  a.erase(a.begin(), a.end());
+  REQUIRE(a.empty());
+  REQUIRE(a.capacity() != 0);
+}
+
+TEST_CASE("Trivially copyable small object") {
+  using vector = socow_vector<int, 8>;
+  STATIC_REQUIRE(vector::TRIVIAL_SMALL);
+
+  vector a;
+  for (int i = 0; i != 5; ++i) {
+    a.push_back(i);
+  }
+
+  vector b = a;
+  vector c = std::move(b);
+  REQUIRE(b.empty());
+  REQUIRE(c.size() == 5);
+  REQUIRE(c[4] == 4);
+
+  vector d;
+  d.push_back(42);
+  d.swap(c);
+  REQUIRE(c.size() == 1);
+  REQUIRE(c[0] == 42);
+  REQUIRE(d.size() == 5);
+  REQUIRE(d[4] == 4);
+
+  vector e;
+  for (int i = 0; i != 20; ++i) {
+    e.push_back(i);
+  }
+  e.swap(d);
+  REQUIRE(d.size() == 20);
+  REQUIRE(d[19] == 19);
+  REQUIRE(e.size() == 5);
+  REQUIRE(e[4] == 4);
+  REQUIRE(e.capacity() == 8);
+  e.swap(d);
+  REQUIRE(d.size() == 5);
+  REQUIRE(d.capacity() == 8);
+  REQUIRE(e.size() == 20);
+}
+
+TEST_CASE("Move-only elements") {
+  static constexpr std::size_t N = 50, K = 10;
+
+  socow_vector<std::unique_ptr<int>, 3> a;
+  for (std::size_t i = 0; i < N; ++i) {
+    a.push_back(std::make_unique<int>(2 * i + 1));
+  }
+  a.insert(a.begin() + K, std::make_unique<int>(42));
+  a.erase(a.begin() + K + 1);
+
+  REQUIRE(a.size() == N);
+  REQUIRE(*a[K] == 42);
+
+  socow_vector<std::unique_ptr<int>, 3> b = std::move(a);
+  REQUIRE(a.empty());
+  REQUIRE(b.size() == N);
+
+  b.shrink_to_fit();
+  for (std::size_t i = 0; i < N; ++i) {
+    CAPTURE(i);
+    REQUIRE(*b[i] == (i == K ? 42 : 2 * i + 1));
+  }
+
+  socow_vector<std::unique_ptr<int>, 3> c;
+  c.push_back(std::make_unique<int>(1));
+  c.swap(b);
+  REQUIRE(c.size() == N);
+  REQUIRE(b.size() == 1);
+  REQUIRE(*b[0] == 1);
+
+  socow_vector<std::unique_ptr<int>, 3> d = std::move(b);
+  REQUIRE(b.empty());
+  REQUIRE(d.size() == 1);
+  REQUIRE(*d.back() == 1);
+}
+
+TEST_CASE("Reserve small object") {
+  element::no_new_intances_guard ig;
+
+  socow_vector<element, 3> a;
+  mass_push_back(a, 2);
+
+  a.reserve(10);
+  REQUIRE_FALSE(is_static_storage(a));
+  REQUIRE(a.capacity() == 10);
+  REQUIRE(a.size() == 2);
+  REQUIRE(a[0] == 1);
+  REQUIRE(a[1] == 3);
+}
+
+TEST_CASE("Resize for overwrite") {
+  socow_vector<int, 3> a;
+
+  a.resize_for_overwrite(2);
+  REQUIRE(a.size() == 2);
+  REQUIRE(a.capacity() == 3);
+  a[0] = 1;
+  a[1] = 2;
+
+  a.resize_for_overwrite(50);
+  REQUIRE(a.size() == 50);
+  REQUIRE(a.capacity() >= 50);
+  REQUIRE(a[0] == 1);
+  REQUIRE(a[1] == 2);
+
+  socow_vector<int, 3> b = a;
+  b.resize_for_overwrite(1);
+  REQUIRE(b.size() == 1);
+  REQUIRE(a.size() == 50);
+}
+
+TEST_CASE("Append uninitialized") {
+  static constexpr std::size_t N = 50;
+
+  socow_vector<int, 3> a;
+
+  std::size_t appended = a.append_uninitialized(2, [](int* p) {
+    p[0] = 0;
+    p[1] = 1;
+  });
+  REQUIRE(appended == 2);
+  REQUIRE(a.size() == 2);
+
+  socow_vector<int, 3> b = a;
+
+  appended = a.append_uninitialized(N, [](int* p) {
+    for (std::size_t i = 0; i < N / 2; ++i) {
+      p[i] = i + 2;
+    }
+    return N / 2;
+  });
+  REQUIRE(appended == N / 2);
+  REQUIRE(a.size() == N / 2 + 2);
+  REQUIRE(a.capacity() >= N + 2);
+
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    CAPTURE(i);
+    REQUIRE(a[i] == i);
+  }
+  REQUIRE(b.size() == 2);
+
+  socow_vector<int, 3> c = a;
+  c.append_uninitialized(1, [](int* p) { *p = -1; });
+  REQUIRE(c.back() == -1);
+  REQUIRE(a.size() == N / 2 + 2);
+}
+
+TEST_CASE("Default small size") {
+  socow_vector<int> a;
+  REQUIRE(a.capacity() == socow_small_size<int>());
+  for (int i = 0; i != 100; ++i) {
+    a.push_back(i);
+  }
+  REQUIRE(a.size() == 100);
+  REQUIRE(a[99] == 99);
+
+  socow_vector<std::array<char, 100>> b;
+  REQUIRE(b.capacity() == 0);
+  b.push_back({'a'});
+  b.push_back({'b'});
+  socow_vector<std::array<char, 100>> c = b;
+  c.pop_back();
+  REQUIRE(b.size() == 2);
+  REQUIRE(c.size() == 1);
+  REQUIRE(c[0][0] == 'a');
+}
+
+TEST_CASE("Memory usage") {
+  using vector_type = socow_vector<int, 3>;
+  static constexpr std::size_t CONTROL_BLOCK = shared_data<vector<int>>::control_block_size();
+
+  vector_type a;
+  a.push_back(1);
+  socow_memory_usage small = a.memory_usage();
+  REQUIRE(small.inline_bytes == sizeof(vector_type));
+  REQUIRE(small.heap_bytes == 0);
+  REQUIRE(small.shared_bytes == 0);
+
+  for (int i = 0; i < 10; ++i) {
+    a.push_back(i);
+  }
+  std::size_t heap_bytes = a.capacity() * sizeof(int) + CONTROL_BLOCK;
+  REQUIRE(a.memory_usage().heap_bytes == heap_bytes);
+  REQUIRE(a.memory_usage().shared_bytes == heap_bytes);
+
+  SECTION("shared buffer") {
+    vector_type b = a;
+    vector_type c = a;
+    for (const vector_type* v : {&a, &b, &c}) {
+      socow_memory_usage usage = v->memory_usage();
+      REQUIRE(usage.inline_bytes == sizeof(vector_type));
+      REQUIRE(usage.heap_bytes == heap_bytes);
+      REQUIRE(usage.shared_bytes * 3 == heap_bytes);
+    }
+  }
+
+  SECTION("nested vectors") {
+    socow_vector<vector_type, 1> outer;
+    outer.push_back(a);
+    outer.push_back(vector_type());
+    std::size_t outer_bytes =
+        outer.capacity() * sizeof(vector_type) + shared_data<vector<vector_type>>::control_block_size();
+
+    socow_memory_usage usage = outer.memory_usage();
+    REQUIRE(usage.heap_bytes == outer_bytes + heap_bytes);
+    REQUIRE(usage.shared_bytes == outer_bytes + heap_bytes / 2.0);
+
+    auto copy = outer;
+    REQUIRE(copy.memory_usage().shared_bytes == (outer_bytes + heap_bytes / 2.0) / 2);
+  }
+
+  SECTION("custom visitor") {
+    socow_vector<std::string, 1> strings;
+    strings.push_back("first");
+    strings.push_back("second");
+    socow_memory_usage usage = strings.memory_usage([](const std::string&) { return socow_memory_usage{0, 100, 100}; });
+    REQUIRE(usage.heap_bytes == strings.memory_usage().heap_bytes + 200);
+    REQUIRE(usage.shared_bytes == strings.memory_usage().shared_bytes + 200);
+  }
+}
+
+TEST_CASE("Release buffer") {
+  socow_vector<int, 3> a;
+  for (int i = 0; i < 10; ++i) {
+    a.push_back(i);
+  }
+
+  SECTION("unique buffer") {
+    const int* buffer = std::as_const(a).data();
+    vector<int> released = a.release();
+    REQUIRE(a.empty());
+    REQUIRE(a.capacity() == 3);
+    REQUIRE(released.data() == buffer);
+    REQUIRE(released.size() == 10);
+    REQUIRE(released[9] == 9);
+  }
+
+  SECTION("shared buffer") {
+    socow_vector<int, 3> b = a;
+    vector<int> released = a.release();
+    REQUIRE(a.empty());
+    REQUIRE(released.data() != std::as_const(b).data());
+    REQUIRE(released.size() == 10);
+    REQUIRE(b.size() == 10);
+    REQUIRE(b[9] == 9);
+  }
+
+  SECTION("inline elements") {
+    socow_vector<int, 3> c;
+    c.push_back(1);
+    c.push_back(2);
+    vector<int> released = c.release();
+    REQUIRE(c.empty());
+    REQUIRE(released.size() == 2);
+    REQUIRE(released[1] == 2);
+    REQUIRE(socow_vector<int, 3>().release().data() == nullptr);
+  }
+}
+
+TEST_CASE("Release shared memfd buffer") {
+  socow_vector<int, 3, memfd_storage<4096>> a;
+  for (int i = 0; i < 100000; ++i) {
+    a.push_back(i);
+  }
+  socow_vector<int, 3, memfd_storage<4096>> b = a;
+
+  vector<int, memfd_storage<4096>> released = a.release();
+  released[0] = 42;
+  vector<int, memfd_storage<4096>> copy = released;
+  REQUIRE(copy[0] == 42);
+  REQUIRE(copy[99999] == 99999);
+  REQUIRE(std::as_const(b)[0] == 0);
+}
+
+TEST_CASE("Adopt buffer") {
+  vector<int> buffer;
+  for (int i = 0; i < 10; ++i) {
+    buffer.push_back(i);
+  }
+  const int* data = buffer.data();
+  socow_vector<int, 3> a = socow_vector<int, 3>::adopt(std::move(buffer));
+  REQUIRE_FALSE(a.small_object());
+  REQUIRE(std::as_const(a).data() == data);
+  REQUIRE(a.size() == 10);
+
+  socow_vector<int, 3> b = a;
+  b[0] = 42;
+  REQUIRE(a[0] == 0);
+
+  vector<int> small;
+  small.push_back(1);
+  socow_vector<int, 3> c = socow_vector<int, 3>::adopt(std::move(small));
+  REQUIRE(c.small_object());
+  REQUIRE(c.size() == 1);
+  REQUIRE(c[0] == 1);
+
+  // A round trip through the owning vector touches no element
+  const int* round_trip = std::as_const(a).data();
+  b = socow_vector<int, 3>();
+  a = socow_vector<int, 3>::adopt(a.release());
+  REQUIRE(std::as_const(a).data() == round_trip);
+}
+
+TEST_CASE("Release and adopt move-only elements") {
+  socow_vector<std::unique_ptr<int>, 3> a;
+  for (int i = 0; i < 10; ++i) {
+    a.push_back(std::make_unique<int>(i));
+  }
+  vector<std::unique_ptr<int>> released = a.release();
+  REQUIRE(*released[9] == 9);
+  a = socow_vector<std::unique_ptr<int>, 3>::adopt(std::move(released));
+  REQUIRE(a.size() == 10);
+  REQUIRE(*a[9] == 9);
+}